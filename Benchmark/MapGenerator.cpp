@@ -0,0 +1,130 @@
+#include "MapGenerator.h"
+
+#include <cmath>
+#include <algorithm>
+
+MapGeneratorSettings defaultMapSettings(int roomsX, int roomsY, float tileSize) {
+	MapGeneratorSettings settings;
+	settings.roomsX = roomsX;
+	settings.roomsY = roomsY;
+	settings.roomSize = 16.0f;
+	settings.wallHeight = 6.0f;
+	settings.wallDensity = 0.3f;
+	settings.portalableRatio = 0.4f;
+	settings.tileSize = tileSize;
+	settings.doorWidth = 3.0f;
+	settings.doorHeight = 4.0f;
+	settings.seed = 12345;
+	return settings;
+}
+
+MapGenerator::MapGenerator(const MapGeneratorSettings &settings) : settings(settings), state(settings.seed), quadCount(0) {
+}
+
+long long MapGenerator::write(const string &mapPath, const string &winPath) {
+	state = settings.seed;
+	quadCount = 0;
+	ofstream out(mapPath);
+	if (!out) {
+		std::cout << "Map failed to write at path: " << mapPath << std::endl;
+		return 0;
+	}
+	float size = settings.roomSize;
+	float height = settings.wallHeight;
+	for (int y = 0; y < settings.roomsY; ++y) {
+		for (int x = 0; x < settings.roomsX; ++x) {
+			glm::vec3 corner(x * size, y * size, 0.0f);
+			writeSurface(out, corner, glm::vec3(size, 0.0f, 0.0f), glm::vec3(0.0f, size, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), MAP_TEXTURE_FLOOR);
+			writeSurface(out, corner + glm::vec3(0.0f, 0.0f, height), glm::vec3(size, 0.0f, 0.0f), glm::vec3(0.0f, size, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), MAP_TEXTURE_CEILING);
+			// every room owns its walls at the low x and low y side, the outer walls close the grid
+			bool outerX = (x == 0), outerY = (y == 0);
+			writeWall(out, corner, corner + glm::vec3(0.0f, size, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), !outerX && random01() >= settings.wallDensity);
+			writeWall(out, corner, corner + glm::vec3(size, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), !outerY && random01() >= settings.wallDensity);
+			if (x == settings.roomsX - 1) {
+				writeWall(out, corner + glm::vec3(size, 0.0f, 0.0f), corner + glm::vec3(size, size, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), false);
+			}
+			if (y == settings.roomsY - 1) {
+				writeWall(out, corner + glm::vec3(0.0f, size, 0.0f), corner + glm::vec3(size, size, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), false);
+			}
+		}
+	}
+	out.close();
+
+	ofstream winFile(winPath);
+	if (!winFile) {
+		std::cout << "Map failed to write at path: " << winPath << std::endl;
+		return quadCount;
+	}
+	glm::vec3 win = roomCenter(settings.roomsX - 1, settings.roomsY - 1);
+	winFile << win.x << " " << win.y << " " << win.z << endl;
+	winFile.close();
+	return quadCount;
+}
+
+long long MapGenerator::estimateQuads() const {
+	long long tiles = (long long)ceil(settings.roomSize / settings.tileSize);
+	long long rows = (long long)ceil(settings.wallHeight / settings.tileSize);
+	long long rooms = (long long)settings.roomsX * settings.roomsY;
+	long long walls = rooms * 2 + settings.roomsX + settings.roomsY;
+	return rooms * tiles * tiles * 2 + walls * tiles * rows;
+}
+
+glm::vec3 MapGenerator::roomCenter(int x, int y) const {
+	return glm::vec3((x + 0.5f) * settings.roomSize, (y + 0.5f) * settings.roomSize, 0.0f);
+}
+
+float MapGenerator::random01() {
+	state = state * 1664525u + 1013904223u;
+	return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+void MapGenerator::writeSurface(ofstream &out, glm::vec3 origin, glm::vec3 u, glm::vec3 v, glm::vec3 n, int texture) {
+	float lengthU = glm::length(u), lengthV = glm::length(v);
+	if (lengthU <= 0.0f || lengthV <= 0.0f) {
+		return;
+	}
+	int tilesU = max(1, (int)ceil(lengthU / settings.tileSize - 0.001f));
+	int tilesV = max(1, (int)ceil(lengthV / settings.tileSize - 0.001f));
+	glm::vec3 p[4];
+	for (int j = 0; j < tilesV; ++j) {
+		for (int i = 0; i < tilesU; ++i) {
+			glm::vec3 a = origin + u * ((float)i / tilesU) + v * ((float)j / tilesV);
+			glm::vec3 b = origin + u * ((float)(i + 1) / tilesU) + v * ((float)(j + 1) / tilesV);
+			glm::vec3 du = u * (1.0f / tilesU), dv = v * (1.0f / tilesV);
+			p[0] = a;
+			p[1] = a + du;
+			p[2] = b;
+			p[3] = a + dv;
+			int tileTexture = texture;
+			if (texture == MAP_TEXTURE_WALL && random01() < settings.portalableRatio) {
+				tileTexture = MAP_TEXTURE_PORTALABLE;
+			}
+			writeQuad(out, p, n, tileTexture);
+		}
+	}
+}
+
+void MapGenerator::writeWall(ofstream &out, glm::vec3 a, glm::vec3 b, glm::vec3 n, bool door) {
+	glm::vec3 up(0.0f, 0.0f, settings.wallHeight);
+	float length = glm::distance(a, b);
+	float doorWidth = min(settings.doorWidth, length - 1.0f);
+	float doorHeight = min(settings.doorHeight, settings.wallHeight);
+	if (!door || doorWidth <= 0.0f) {
+		writeSurface(out, a, b - a, up, n, MAP_TEXTURE_WALL);
+		return;
+	}
+	glm::vec3 dir = (b - a) / length;
+	float side = (length - doorWidth) * 0.5f;
+	writeSurface(out, a, dir * side, up, n, MAP_TEXTURE_WALL);
+	writeSurface(out, a + dir * (side + doorWidth), dir * side, up, n, MAP_TEXTURE_WALL);
+	writeSurface(out, a + dir * side + glm::vec3(0.0f, 0.0f, doorHeight), dir * doorWidth, glm::vec3(0.0f, 0.0f, settings.wallHeight - doorHeight), n, MAP_TEXTURE_WALL);
+}
+
+void MapGenerator::writeQuad(ofstream &out, const glm::vec3 *p, glm::vec3 n, int texture) {
+	out << "R\n";
+	for (int i = 0; i < 4; ++i) {
+		out << p[i].x << " " << p[i].y << " " << p[i].z << "\n";
+	}
+	out << "N\n" << n.x << " " << n.y << " " << n.z << "\nT\n" << texture << "\n\n";
+	++quadCount;
+}
@@ -0,0 +1,58 @@
+#ifndef MAP_GENERATOR_H
+#define MAP_GENERATOR_H
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+// texture ids of the map format used by the generated quads
+#define MAP_TEXTURE_WALL 1
+#define MAP_TEXTURE_FLOOR 2
+#define MAP_TEXTURE_PORTALABLE 3
+#define MAP_TEXTURE_CEILING 6
+
+struct MapGeneratorSettings {
+	int roomsX, roomsY;		// rooms along x and y
+	float roomSize;			// edge length of a room
+	float wallHeight;
+	float wallDensity;		// chance that a wall between two rooms has no door
+	float portalableRatio;	// share of the wall tiles portals can be shot at
+	float tileSize;			// every surface is split into tiles of this size, controls the quad count
+	float doorWidth, doorHeight;
+	unsigned int seed;
+};
+
+// default settings for a grid of rooms
+MapGeneratorSettings defaultMapSettings(int roomsX, int roomsY, float tileSize);
+
+// Writes grid-of-rooms maps in the R/N/T format read by Physics and Model. Every room has a
+// floor, a ceiling and walls shared with its neighbours; shared walls randomly get a door.
+class MapGenerator {
+public:
+	MapGenerator(const MapGeneratorSettings &settings);
+
+	// writes the map and its win point (centre of the last room), returns the number of quads written
+	long long write(const string &mapPath, const string &winPath);
+	// roughly the quads a map with these settings has, without writing it
+	long long estimateQuads() const;
+	// a point standing on the floor of the room (x, y)
+	glm::vec3 roomCenter(int x, int y) const;
+
+private:
+	MapGeneratorSettings settings;
+	unsigned int state;
+	long long quadCount;
+
+	float random01();
+	// splits the rectangle origin + s * u + t * v (s, t in [0, 1]) into tiles
+	void writeSurface(ofstream &out, glm::vec3 origin, glm::vec3 u, glm::vec3 v, glm::vec3 n, int texture);
+	// a wall from a to b standing on z = 0, with a door in the middle if door is set
+	void writeWall(ofstream &out, glm::vec3 a, glm::vec3 b, glm::vec3 n, bool door);
+	void writeQuad(ofstream &out, const glm::vec3 *p, glm::vec3 n, int texture);
+};
+
+#endif
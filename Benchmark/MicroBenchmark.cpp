@@ -0,0 +1,384 @@
+// Times the hot functions of Physics, PortalManager and Camera on inputs replayed from a play session.
+// No GL context is created. Run it from the Portal directory so the map is found. Results are written as CSV.
+//
+// usage: MicroBenchmark [--recording play_recording.txt] [--map Map4.txt] [--win Win4.txt] [--out micro_benchmark.csv]
+//
+// Without a recording (F8 in the game writes one) a scripted session is simulated on the map instead.
+// Everything measured runs every frame, so the benchmark fails if any of it allocates.
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#include "Physics.h"
+#include "PortalManager.h"
+#include "Frustum.h"
+#include "Camera.h"
+#include "PlayRecording.h"
+#include "AllocationCounter.h"
+
+using namespace std;
+
+// every benchmark runs over its inputs until this much time has passed
+const double MICRO_MIN_SECONDS = 0.5;
+// frames of the scripted session used when there is no recording
+const int SIMULATED_FRAMES = 7200;
+
+// cache misses
+// ------------
+// counts hardware cache misses of this thread where perf counters are available
+class CacheMissCounter {
+public:
+	CacheMissCounter() : fd(-1) {
+#ifdef __linux__
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+	}
+	~CacheMissCounter() {
+#ifdef __linux__
+		if (fd >= 0) {
+			close(fd);
+		}
+#endif
+	}
+	bool isAvailable() const {
+		return fd >= 0;
+	}
+	void start() {
+#ifdef __linux__
+		if (fd >= 0) {
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+	long long stop() {
+		long long count = 0;
+#ifdef __linux__
+		if (fd >= 0) {
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+				count = 0;
+			}
+		}
+#endif
+		return count;
+	}
+
+private:
+	int fd;
+};
+
+// timing
+// ------
+struct MicroResult {
+	string name;
+	long long ops;
+	double nsPerOp, allocsPerOp, cacheMissesPerOp;	// negative when not available
+};
+
+// results of the benchmarked calls are folded in here so they can't be optimised away
+volatile double sink = 0.0;
+
+// runs op(i) over all inputs, repeating the passes until MICRO_MIN_SECONDS have passed
+template<typename Op>
+MicroResult runMicro(const string &name, int inputCount, CacheMissCounter &counter, Op op) {
+	for (int i = 0; i < inputCount; ++i) {
+		op(i);
+	}
+	unsigned long long allocations = allocationCount();
+	long long ops = 0;
+	double elapsed = 0.0;
+	counter.start();
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	while (elapsed < MICRO_MIN_SECONDS) {
+		for (int i = 0; i < inputCount; ++i) {
+			op(i);
+		}
+		ops += inputCount;
+		elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	}
+	long long misses = counter.stop();
+	unsigned long long made = allocationCount() - allocations;
+	MicroResult result;
+	result.name = name;
+	result.ops = ops;
+	result.nsPerOp = elapsed * 1e9 / ops;
+	result.allocsPerOp = isCountingAllocations() ? (double)made / ops : -1.0;
+	result.cacheMissesPerOp = counter.isAvailable() ? (double)misses / ops : -1.0;
+	return result;
+}
+
+// inputs
+// ------
+float random01(unsigned int &seed) {
+	seed = seed * 1664525u + 1013904223u;
+	return (seed >> 8) * (1.0f / 16777216.0f);
+}
+
+// plays the map the way the game loop does: walking, turning, jumping and shooting portals
+void simulatePlay(Physics &physics, PlayRecording &recording) {
+	Camera camera(glm::vec3(8.0f, 8.0f, 2.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	glm::vec3 playerSize(0.0f, 0.0f, 2.0f);
+	glm::vec3 speed(0.0f, 0.0f, 0.0f), keyboardSpeed(0.0f, 0.0f, 0.0f);
+	bool isJumping = false;
+	unsigned int seed = 12345;
+	float turn = 0.0f;
+	for (int frame = 0; frame < SIMULATED_FRAMES; ++frame) {
+		float deltaTime = 1.0f / 60.0f + (random01(seed) - 0.5f) * 0.002f;
+		glm::vec3 playerPos = camera.Position - playerSize;
+		PlaySample sample = { playerPos, speed, keyboardSpeed, camera.Front, camera.Yaw, camera.Pitch, deltaTime };
+		recording.samples.push_back(sample);
+
+		physics.updateVerticleState(speed, playerPos, deltaTime, isJumping);
+		camera.Position = playerSize + playerPos;
+
+		// the mouse drifts with an occasional quick look around
+		turn = turn * 0.95f + (random01(seed) - 0.5f) * 4.0f;
+		if (random01(seed) < 0.005f) {
+			turn += (random01(seed) - 0.5f) * 200.0f;
+		}
+		camera.ProcessMouseMovement(turn, (random01(seed) - 0.5f) * 6.0f - camera.Pitch * 0.5f);
+
+		keyboardSpeed = glm::vec3(0.0f, 0.0f, 0.0f);
+		Camera_Movement direction = (random01(seed) < 0.8f) ? FORWARD : ((frame / 90) % 2 == 0 ? LEFT : RIGHT);
+		glm::vec3 axis = (direction == FORWARD) ? camera.Heading : camera.Right;
+		float sign = (direction == LEFT) ? -1.0f : 1.0f;
+		glm::vec3 movement = axis * camera.MovementSpeed * deltaTime * 35.0f * sign;
+		if (physics.isHorizontalAvailable(camera.Position, movement)) {
+			camera.ProcessKeyboard(direction, deltaTime);
+			keyboardSpeed += movement;
+		}
+		else {
+			turn += 60.0f;
+		}
+		if (!isJumping && random01(seed) < 0.01f) {
+			speed.z = -8.0f;
+			isJumping = true;
+		}
+
+		if (frame % 180 == 90) {
+			glm::vec3 pos, n, up;
+			if (physics.isIntersected(camera.Position, camera.Front, pos, n, up)) {
+				PortalPlacement placement = { (frame / 180) % 2, pos, n, up };
+				recording.placements.push_back(placement);
+			}
+		}
+	}
+}
+
+// the first floor quad of a map, projected onto the xy plane
+vector<pair<double, double>> readFloorPolygon(const string &path) {
+	vector<pair<double, double>> polygon;
+	ifstream inFile(path);
+	char type;
+	while (inFile >> type && type == 'R') {
+		double p[4][3], n[3];
+		int textureId;
+		char ch;
+		for (int i = 0; i < 4; ++i) {
+			inFile >> p[i][0] >> p[i][1] >> p[i][2];
+		}
+		inFile >> ch >> n[0] >> n[1] >> n[2] >> ch >> textureId;
+		if (n[0] == 0 && n[1] == 0) {
+			for (int i = 0; i < 4; ++i) {
+				polygon.push_back(make_pair(p[i][0], p[i][1]));
+			}
+			break;
+		}
+	}
+	return polygon;
+}
+
+string csvValue(double value) {
+	if (value < 0.0) {
+		return "";
+	}
+	ostringstream out;
+	out << value;
+	return out.str();
+}
+
+int main(int argc, char **argv) {
+	string recordingPath = "play_recording.txt", mapPath = "Map4.txt", winPath = "Win4.txt", outPath = "micro_benchmark.csv";
+	for (int i = 1; i < argc; i += 2) {
+		string *value = NULL;
+		if (strcmp(argv[i], "--recording") == 0) {
+			value = &recordingPath;
+		}
+		else if (strcmp(argv[i], "--map") == 0) {
+			value = &mapPath;
+		}
+		else if (strcmp(argv[i], "--win") == 0) {
+			value = &winPath;
+		}
+		else if (strcmp(argv[i], "--out") == 0) {
+			value = &outPath;
+		}
+		if (value == NULL || i + 1 >= argc) {
+			std::cout << "usage: MicroBenchmark [--recording file] [--map file] [--win file] [--out file.csv]" << std::endl;
+			return -1;
+		}
+		*value = argv[i + 1];
+	}
+
+	Physics physics(mapPath, winPath, glm::vec3(0.0f, 0.0f, 1.0f));
+	PlayRecording recording;
+	if (ifstream(recordingPath).good() && recording.load(recordingPath) && !recording.samples.empty()) {
+		std::cout << "replaying " << recording.samples.size() << " frames of " << recordingPath << std::endl;
+	}
+	else {
+		recording.samples.clear();
+		recording.placements.clear();
+		simulatePlay(physics, recording);
+		std::cout << "no recording, simulated " << recording.samples.size() << " frames on " << mapPath << std::endl;
+	}
+	const vector<PlaySample> &samples = recording.samples;
+	int count = (int)samples.size();
+	glm::vec3 playerSize(0.0f, 0.0f, 2.0f);
+
+	// the last portals of every pair placed in the session
+	PortalManager portals;
+	bool linked = false;
+	for (const PortalPlacement &placement : recording.placements) {
+		portals.placePortal(placement.type, placement.pos, placement.n, placement.up);
+		linked = linked || (placement.type >= 0 && placement.type < portals.portalCount() && portals.linked[placement.type]);
+	}
+	portals.cutOpenings(physics);
+
+	// mouse movement between the recorded frames
+	vector<glm::vec2> mouseOffsets(count);
+	for (int i = 1; i < count; ++i) {
+		mouseOffsets[i] = glm::vec2(samples[i].yaw - samples[i - 1].yaw, samples[i].pitch - samples[i - 1].pitch) / SENSITIVTY;
+	}
+
+	vector<pair<double, double>> floorPolygon = readFloorPolygon(mapPath);
+
+	CacheMissCounter counter;
+	vector<MicroResult> results;
+
+	results.push_back(runMicro("Physics::updateVerticleState", count, counter, [&](int i) {
+		glm::vec3 v = samples[i].speed, pos = samples[i].playerPos;
+		bool isJumping = (v.z != 0.0f);
+		physics.updateVerticleState(v, pos, samples[i].deltaTime, isJumping);
+		sink = sink + pos.z;
+	}));
+	results.push_back(runMicro("Physics::isHorizontalAvailable", count, counter, [&](int i) {
+		glm::vec3 pos = samples[i].playerPos + playerSize;
+		glm::vec3 front = samples[i].front;
+		front.z = 0.0f;
+		glm::vec3 movement = glm::normalize(front) * SPEED * samples[i].deltaTime * 35.0f;
+		sink = sink + physics.isHorizontalAvailable(pos, movement);
+	}));
+	results.push_back(runMicro("Physics::isIntersected", count, counter, [&](int i) {
+		glm::vec3 pos, n, up;
+		sink = sink + physics.isIntersected(samples[i].playerPos + playerSize, samples[i].front, pos, n, up);
+	}));
+	if (!floorPolygon.empty()) {
+		results.push_back(runMicro("Physics::isInPolygon", count, counter, [&](int i) {
+			sink = sink + physics.isInPolygon(make_pair((double)samples[i].playerPos.x, (double)samples[i].playerPos.y), floorPolygon);
+		}));
+	}
+	if (linked) {
+		results.push_back(runMicro("PortalManager::passPortal", count, counter, [&](int i) {
+			glm::vec3 from = samples[i].playerPos + playerSize, front = samples[i].front;
+			glm::vec3 velocity(samples[i].speed.x, samples[i].speed.y, -samples[i].speed.z);
+			glm::vec3 to = from + velocity * samples[i].deltaTime + samples[i].keyboardSpeed;
+			float timeOfImpact;
+			sink = sink + portals.passPortal(from, to, velocity, front, playerSize.z, timeOfImpact) + timeOfImpact;
+		}));
+		glm::mat4 projection = glm::perspective(glm::radians(ZOOM), 1366.0f / 768.0f, 0.1f, 100.0f);
+		results.push_back(runMicro("PortalManager::visiblePortals", count, counter, [&](int i) {
+			glm::vec3 eye = samples[i].playerPos + playerSize;
+			Frustum frustum;
+			frustum.extract(projection * glm::lookAt(eye, eye + samples[i].front, glm::vec3(0.0f, 0.0f, 1.0f)));
+			int visible[4];
+			sink = sink + portals.visiblePortals(frustum, eye, 4, visible);
+		}));
+	}
+	else {
+		std::cout << "no portal pair was placed, PortalManager is not measured" << std::endl;
+	}
+	Camera camera(glm::vec3(8.0f, 8.0f, 2.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	results.push_back(runMicro("Camera::updateCameraVectors", count, counter, [&](int i) {
+		// through ProcessMouseMovement, its only caller
+		camera.ProcessMouseMovement(mouseOffsets[i].x, mouseOffsets[i].y);
+		sink = sink + camera.Front.x;
+	}));
+
+	Camera frameCamera(glm::vec3(8.0f, 8.0f, 2.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	results.push_back(runMicro("frame simulation", count, counter, [&](int i) {
+		// the state update of one frame of the game loop, with the movement keys checked
+		glm::vec3 speed = samples[i].speed, playerPos = samples[i].playerPos;
+		bool isJumping = (speed.z != 0.0f);
+		float deltaTime = samples[i].deltaTime;
+		sink = sink + physics.isWin(playerPos);
+		physics.updateVerticleState(speed, playerPos, deltaTime, isJumping);
+		glm::vec3 cameraPos = playerPos + playerSize;
+		glm::vec3 drift = glm::vec3(speed.x, speed.y, 0.0f) * deltaTime;
+		if ((drift.x != 0.0f || drift.y != 0.0f) && physics.isHorizontalAvailable(cameraPos, drift)) {
+			cameraPos += drift;
+		}
+		glm::vec3 velocity(speed.x, speed.y, -speed.z), front = frameCamera.Front;
+		float timeOfImpact;
+		if (portals.passPortal(samples[i].playerPos + playerSize, cameraPos, velocity, front, playerSize.z, timeOfImpact) >= 0) {
+			frameCamera.SetFront(front);
+		}
+		frameCamera.Position = cameraPos;
+		frameCamera.ProcessMouseMovement(mouseOffsets[i].x, mouseOffsets[i].y);
+		glm::vec3 forward = frameCamera.Heading * frameCamera.MovementSpeed * deltaTime * 35.0f;
+		glm::vec3 right = frameCamera.Right * frameCamera.MovementSpeed * deltaTime * 35.0f;
+		sink = sink + physics.isHorizontalAvailable(frameCamera.Position, forward) + physics.isHorizontalAvailable(frameCamera.Position, right);
+	}));
+
+	ofstream out(outPath);
+	if (!out) {
+		std::cout << "Failed to open benchmark output: " << outPath << std::endl;
+		return -1;
+	}
+	const char *header = "benchmark,ops,ns_per_op,allocs_per_op,cache_misses_per_op";
+	out << header << endl;
+	std::cout << header << std::endl;
+	for (const MicroResult &result : results) {
+		ostringstream row;
+		row << result.name << "," << result.ops << "," << result.nsPerOp << "," << csvValue(result.allocsPerOp) << "," << csvValue(result.cacheMissesPerOp);
+		out << row.str() << endl;
+		std::cout << row.str() << std::endl;
+	}
+	out.close();
+
+	int failed = 0;
+	for (const MicroResult &result : results) {
+		if (result.allocsPerOp > 0.0) {
+			std::cout << "FAILED: " << result.name << " makes " << result.allocsPerOp << " heap allocations per call" << std::endl;
+			++failed;
+		}
+	}
+	if (!isCountingAllocations()) {
+		std::cout << "allocations are not counted, build with PORTAL_COUNT_ALLOCATIONS" << std::endl;
+	}
+	return failed > 0 ? 1 : 0;
+}
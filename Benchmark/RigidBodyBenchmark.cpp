@@ -0,0 +1,153 @@
+// Drops growing numbers of boxes into a generated room with a pair of portals and measures the cost of one
+// fixed step of RigidBodies against the box count, on this thread alone and spread over all cores with the
+// job system. No GL context is created. Results are written as CSV.
+//
+// usage: RigidBodyBenchmark [--quick] [--keep-maps] [--threads n] [--out rigid_body_benchmark.csv]
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include "MapGenerator.h"
+#include "Physics.h"
+#include "PortalManager.h"
+#include "RigidBodies.h"
+#include "JobSystem.h"
+
+using namespace std;
+
+// steps run before measuring, so the boxes have landed and piled up
+const int WARMUP_STEPS = 240;
+const int MEASURED_STEPS = 600;
+const float BOX_HALF_SIZE = 0.4f;
+
+struct BodyCount {
+	int count;
+	bool quick;		// part of the --quick run
+};
+
+const BodyCount bodyCounts[] = {
+	{ 64, true }, { 128, true }, { 256, true }, { 512, true }, { 1024, false }, { 2048, false },
+};
+
+double secondsSince(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+float random01(unsigned int &seed) {
+	seed = seed * 1664525u + 1013904223u;
+	return (seed >> 8) * (1.0f / 16777216.0f);
+}
+
+// boxes on a jittered grid filling the room from the floor up
+void dropBoxes(RigidBodies &bodies, int count, const MapGeneratorSettings &settings) {
+	unsigned int seed = 7;
+	float spacing = BOX_HALF_SIZE * 2.5f;
+	int perRow = (int)((settings.roomSize - 2.0f) / spacing);
+	for (int i = 0; i < count; ++i) {
+		int layer = i / (perRow * perRow);
+		int cell = i % (perRow * perRow);
+		glm::vec3 pos(1.0f + (cell % perRow + 0.5f) * spacing, 1.0f + (cell / perRow + 0.5f) * spacing, 1.0f + layer * spacing);
+		pos += glm::vec3(random01(seed) - 0.5f, random01(seed) - 0.5f, 0.0f) * 0.2f;
+		glm::vec3 velocity((random01(seed) - 0.5f) * 4.0f, (random01(seed) - 0.5f) * 4.0f, 0.0f);
+		bodies.add(pos, glm::vec3(BOX_HALF_SIZE), velocity);
+	}
+}
+
+int main(int argc, char **argv) {
+	bool quick = false, keepMaps = false;
+	int threadCount = -1;
+	string outPath = "rigid_body_benchmark.csv";
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--quick") == 0) {
+			quick = true;
+		}
+		else if (strcmp(argv[i], "--keep-maps") == 0) {
+			keepMaps = true;
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			threadCount = max(1, atoi(argv[++i])) - 1;
+		}
+		else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+			outPath = argv[++i];
+		}
+		else {
+			std::cout << "usage: RigidBodyBenchmark [--quick] [--keep-maps] [--threads n] [--out file.csv]" << std::endl;
+			return -1;
+		}
+	}
+
+	// one closed room, big enough for the largest pile
+	MapGeneratorSettings settings = defaultMapSettings(1, 1, 4.0f);
+	settings.roomSize = 32.0f;
+	settings.wallHeight = 12.0f;
+	settings.portalableRatio = 0.0f;
+	string mapPath = "bench_bodies.txt", winPath = "bench_bodies_win.txt";
+	MapGenerator generator(settings);
+	generator.write(mapPath, winPath);
+	Physics physics(mapPath, winPath, glm::vec3(0.0f, 0.0f, 1.0f));
+
+	// a floor portal in the middle leading out of a wall, so boxes keep passing through
+	PortalManager portals(1);
+	float half = settings.roomSize / 2.0f;
+	portals.placePortal(0, glm::vec3(half, half, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	portals.placePortal(1, glm::vec3(0.0f, half, 3.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	portals.cutOpenings(physics);
+
+	ofstream out(outPath);
+	if (!out) {
+		std::cout << "Failed to open benchmark output: " << outPath << std::endl;
+		return -1;
+	}
+	JobSystem jobs;
+	jobs.initialize(threadCount);
+	// each count runs on this thread alone, then on all threads if there are more
+	int threadCounts[2] = { 1, jobs.threadCount() };
+	int runs = (jobs.threadCount() > 1) ? 2 : 1;
+	const char *header = "bodies,threads,step_us,step_us_per_body,pairs_per_step,contacts_per_step";
+	out << header << endl;
+	std::cout << header << std::endl;
+
+	for (const BodyCount &bodyCount : bodyCounts) {
+		if (quick && !bodyCount.quick) {
+			continue;
+		}
+		for (int run = 0; run < runs; ++run) {
+			int threads = threadCounts[run];
+			RigidBodies bodies(physics, &portals, (threads > 1) ? &jobs : NULL);
+			dropBoxes(bodies, bodyCount.count, settings);
+			for (int i = 0; i < WARMUP_STEPS; ++i) {
+				bodies.step(RIGID_BODY_STEP);
+			}
+			long long pairs = 0, contacts = 0;
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			for (int i = 0; i < MEASURED_STEPS; ++i) {
+				bodies.step(RIGID_BODY_STEP);
+				pairs += bodies.pairCount;
+				contacts += bodies.contactCount;
+			}
+			double stepUs = secondsSince(start) * 1e6 / MEASURED_STEPS;
+
+			ostringstream row;
+			row << bodyCount.count << "," << threads << "," << stepUs << "," << stepUs / bodyCount.count << ","
+				<< (double)pairs / MEASURED_STEPS << "," << (double)contacts / MEASURED_STEPS;
+			out << row.str() << endl;
+			std::cout << row.str() << std::endl;
+		}
+	}
+	out.close();
+
+	if (!keepMaps) {
+		remove(mapPath.c_str());
+		remove(winPath.c_str());
+	}
+	return 0;
+}
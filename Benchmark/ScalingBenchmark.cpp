@@ -0,0 +1,276 @@
+// Generates maps of growing size and measures how map loading, physics queries and rendering scale with them.
+// Run it from the Portal directory so the shaders and textures are found. Results are written as CSV.
+//
+// usage: ScalingBenchmark [--quick] [--no-render] [--keep-maps] [--out scaling_benchmark.csv]
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+#include "MapGenerator.h"
+#include "Physics.h"
+#include "Model.h"
+#include "Shader.h"
+#include "Frustum.h"
+
+using namespace std;
+
+// a query is repeated until this much time has passed, but at least BENCH_MIN_CALLS times
+const double BENCH_MIN_SECONDS = 0.25;
+const int BENCH_MIN_CALLS = 3;
+// frames rendered for each camera setup
+const int BENCH_FRAMES = 60;
+const unsigned int BENCH_WIDTH = 1366;
+const unsigned int BENCH_HEIGHT = 768;
+
+struct BenchmarkCase {
+	const char *name;
+	int roomsX, roomsY;
+	float tileSize;
+	bool quick;		// part of the --quick run
+};
+
+const BenchmarkCase benchmarkCases[] = {
+	{ "small", 2, 2, 4.0f, true },			// about the size of the shipped maps
+	{ "medium", 8, 8, 2.0f, true },			// ~12k quads
+	{ "large", 24, 24, 1.0f, true },		// ~400k quads
+	{ "huge", 64, 64, 1.0f, false },		// ~3M quads
+};
+
+struct BenchmarkResult {
+	long long quads;
+	double fileMegabytes;
+	double generateMs, physicsLoadMs, verticalQueryUs, horizontalQueryUs, raycastsPerSecond;
+	double modelLoadMs, frameMs, frameUnculledMs;	// negative when not rendered
+};
+
+double secondsSince(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// calls op with an increasing counter until enough time has passed, returns the mean seconds per call
+template<typename Op>
+double timePerCall(Op op) {
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	int calls = 0;
+	double elapsed = 0.0;
+	while (calls < BENCH_MIN_CALLS || elapsed < BENCH_MIN_SECONDS) {
+		op(calls++);
+		elapsed = secondsSince(start);
+	}
+	return elapsed / calls;
+}
+
+float random01(unsigned int &seed) {
+	seed = seed * 1664525u + 1013904223u;
+	return (seed >> 8) * (1.0f / 16777216.0f);
+}
+
+// a random point inside a random room, at a random height between low and high
+glm::vec3 randomPointInRooms(const MapGeneratorSettings &settings, float low, float high, unsigned int &seed) {
+	float margin = 1.0f;
+	float x = random01(seed) * settings.roomsX * settings.roomSize;
+	float y = random01(seed) * settings.roomsY * settings.roomSize;
+	// keep away from the walls so the query starts inside a room
+	x = floor(x / settings.roomSize) * settings.roomSize + margin + fmod(x, settings.roomSize) * (settings.roomSize - 2.0f * margin) / settings.roomSize;
+	y = floor(y / settings.roomSize) * settings.roomSize + margin + fmod(y, settings.roomSize) * (settings.roomSize - 2.0f * margin) / settings.roomSize;
+	return glm::vec3(x, y, low + random01(seed) * (high - low));
+}
+
+glm::vec3 randomDirection(float maxZ, unsigned int &seed) {
+	float yaw = random01(seed) * 6.2832f;
+	float z = (random01(seed) * 2.0f - 1.0f) * maxZ;
+	return glm::normalize(glm::vec3(cos(yaw), sin(yaw), z));
+}
+
+double fileMegabytes(const string &path) {
+	ifstream file(path, ios::binary | ios::ate);
+	if (!file) {
+		return 0.0;
+	}
+	return (double)file.tellg() / (1024.0 * 1024.0);
+}
+
+void measurePhysics(const MapGeneratorSettings &settings, const string &mapPath, const string &winPath, BenchmarkResult &result) {
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	Physics physics(mapPath, winPath, glm::vec3(0.0f, 0.0f, 1.0f));
+	result.physicsLoadMs = secondsSince(start) * 1000.0;
+
+	unsigned int seed = 1;
+	result.verticalQueryUs = timePerCall([&](int) {
+		glm::vec3 pos = randomPointInRooms(settings, 0.1f, settings.wallHeight - 0.1f, seed);
+		glm::vec3 v(0.0f, 0.0f, 0.0f);
+		bool isJumping = false;
+		physics.updateVerticleState(v, pos, 1.0 / 60.0, isJumping);
+	}) * 1e6;
+
+	seed = 2;
+	result.horizontalQueryUs = timePerCall([&](int) {
+		glm::vec3 pos = randomPointInRooms(settings, 0.0f, 0.0f, seed);
+		physics.isHorizontalAvailable(pos, randomDirection(0.0f, seed) * 0.3f);
+	}) * 1e6;
+
+	seed = 3;
+	result.raycastsPerSecond = 1.0 / timePerCall([&](int) {
+		glm::vec3 pos = randomPointInRooms(settings, 1.5f, 2.0f, seed);
+		glm::vec3 hit, n, up;
+		physics.isIntersected(pos, randomDirection(0.5f, seed), hit, n, up);
+	});
+}
+
+// renders BENCH_FRAMES frames from random rooms and returns the mean milliseconds per frame
+double measureFrames(Model &scene, Shader &shader, const MapGeneratorSettings &settings, bool culled) {
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)BENCH_WIDTH / (float)BENCH_HEIGHT, 0.1f, 100.0f);
+	shader.use();
+	shader.setMat4("projection", projection);
+	unsigned int seed = 4;
+	FrameArena arena(256 * 1024);
+	glFinish();
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int i = 0; i < BENCH_FRAMES; ++i) {
+		glm::vec3 eye = randomPointInRooms(settings, 2.0f, 2.0f, seed);
+		glm::mat4 view = glm::lookAt(eye, eye + randomDirection(0.3f, seed), glm::vec3(0.0f, 0.0f, 1.0f));
+		arena.reset();
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		shader.setMat4("view", view);
+		if (culled) {
+			Frustum frustum;
+			frustum.extract(projection * view);
+			scene.DrawChunks(shader, eye, &frustum, scene.pvs.visibleChunks(scene.pvs.cellAt(eye)), true, arena);
+		}
+		else {
+			scene.Draw(shader);
+		}
+		glFinish();
+	}
+	return secondsSince(start) * 1000.0 / BENCH_FRAMES;
+}
+
+void measureRendering(const MapGeneratorSettings &settings, const string &mapPath, Shader &shader, BenchmarkResult &result) {
+	glFinish();
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	Model scene(mapPath);
+	glFinish();
+	result.modelLoadMs = secondsSince(start) * 1000.0;
+	result.frameMs = measureFrames(scene, shader, settings, true);
+	result.frameUnculledMs = measureFrames(scene, shader, settings, false);
+}
+
+// hidden window whose context is used for the rendering measurements, NULL if there is none
+GLFWwindow *createHeadlessContext() {
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow *window = glfwCreateWindow(BENCH_WIDTH, BENCH_HEIGHT, "ScalingBenchmark", NULL, NULL);
+	if (window == NULL) {
+		std::cout << "Failed to create GLFW window, rendering is not measured" << std::endl;
+		return NULL;
+	}
+	glfwMakeContextCurrent(window);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		std::cout << "Failed to initialize GLAD, rendering is not measured" << std::endl;
+		glfwDestroyWindow(window);
+		return NULL;
+	}
+	glViewport(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+	glEnable(GL_DEPTH_TEST);
+	return window;
+}
+
+string csvValue(double value) {
+	if (value < 0.0) {
+		return "";
+	}
+	ostringstream out;
+	out << value;
+	return out.str();
+}
+
+int main(int argc, char **argv) {
+	bool quick = false, render = true, keepMaps = false;
+	string outPath = "scaling_benchmark.csv";
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--quick") == 0) {
+			quick = true;
+		}
+		else if (strcmp(argv[i], "--no-render") == 0) {
+			render = false;
+		}
+		else if (strcmp(argv[i], "--keep-maps") == 0) {
+			keepMaps = true;
+		}
+		else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+			outPath = argv[++i];
+		}
+		else {
+			std::cout << "usage: ScalingBenchmark [--quick] [--no-render] [--keep-maps] [--out file.csv]" << std::endl;
+			return -1;
+		}
+	}
+
+	GLFWwindow *window = render ? createHeadlessContext() : NULL;
+	Shader *shader = (window != NULL) ? new Shader("shader_scene.vs", "shader_scene.fs", nullptr, "TEXTURE_ARRAY") : NULL;
+
+	ofstream out(outPath);
+	if (!out) {
+		std::cout << "Failed to open benchmark output: " << outPath << std::endl;
+		return -1;
+	}
+	const char *header = "map,rooms,quads,file_mb,generate_ms,physics_load_ms,vertical_query_us,horizontal_query_us,raycasts_per_s,model_load_ms,frame_ms,frame_unculled_ms";
+	out << header << endl;
+	std::cout << header << std::endl;
+
+	for (const BenchmarkCase &benchmark : benchmarkCases) {
+		if (quick && !benchmark.quick) {
+			continue;
+		}
+		MapGeneratorSettings settings = defaultMapSettings(benchmark.roomsX, benchmark.roomsY, benchmark.tileSize);
+		string mapPath = string("bench_") + benchmark.name + ".txt";
+		string winPath = string("bench_") + benchmark.name + "_win.txt";
+
+		BenchmarkResult result;
+		result.modelLoadMs = result.frameMs = result.frameUnculledMs = -1.0;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		MapGenerator generator(settings);
+		result.quads = generator.write(mapPath, winPath);
+		result.generateMs = secondsSince(start) * 1000.0;
+		result.fileMegabytes = fileMegabytes(mapPath);
+
+		measurePhysics(settings, mapPath, winPath, result);
+		if (shader != NULL) {
+			measureRendering(settings, mapPath, *shader, result);
+		}
+
+		ostringstream row;
+		row << benchmark.name << "," << benchmark.roomsX * benchmark.roomsY << "," << result.quads << ","
+			<< result.fileMegabytes << "," << result.generateMs << "," << result.physicsLoadMs << ","
+			<< result.verticalQueryUs << "," << result.horizontalQueryUs << "," << result.raycastsPerSecond << ","
+			<< csvValue(result.modelLoadMs) << "," << csvValue(result.frameMs) << "," << csvValue(result.frameUnculledMs);
+		out << row.str() << endl;
+		std::cout << row.str() << std::endl;
+
+		if (!keepMaps) {
+			remove(mapPath.c_str());
+			remove(winPath.c_str());
+		}
+	}
+	out.close();
+
+	delete shader;
+	if (render) {
+		glfwTerminate();
+	}
+	return 0;
+}
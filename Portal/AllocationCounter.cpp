@@ -0,0 +1,61 @@
+#include "AllocationCounter.h"
+
+#ifdef PORTAL_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+#include <atomic>
+
+static std::atomic<unsigned long long> allocations(0);
+static thread_local bool threadIgnored = false;
+
+void *operator new(size_t size) {
+	if (!threadIgnored) {
+		++allocations;
+	}
+	void *p = malloc(size > 0 ? size : 1);
+	if (p == NULL) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void *operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+	free(p);
+}
+
+void operator delete[](void *p) noexcept {
+	free(p);
+}
+
+bool isCountingAllocations() {
+	return true;
+}
+
+unsigned long long allocationCount() {
+	return allocations;
+}
+
+void ignoreThreadAllocations() {
+	threadIgnored = true;
+}
+
+#else
+
+bool isCountingAllocations() {
+	return false;
+}
+
+unsigned long long allocationCount() {
+	return 0;
+}
+
+void ignoreThreadAllocations() {
+	//
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+// Counts heap allocations made through operator new when PORTAL_COUNT_ALLOCATIONS is defined (debug
+// builds and the benchmarks). Used to check that steady-state frames don't allocate.
+bool isCountingAllocations();
+// allocations since the start of the program, always 0 when not counting
+unsigned long long allocationCount();
+// leaves out the allocations of the calling thread from now on, for threads working next to the frames
+// rather than for them, like the level loader and the render thread
+void ignoreThreadAllocations();
+
+#endif
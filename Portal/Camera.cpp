@@ -1,6 +1,7 @@
 #include "Camera.h"
 
-Camera::Camera(glm::vec3 position, glm::vec3 up, float yaw, float pitch) : Front(glm::vec3(-1.0f, 0.0f, 0.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVTY), Zoom(ZOOM) {
+Camera::Camera(glm::vec3 position, glm::vec3 up, float yaw, float pitch) : Front(glm::vec3(-1.0f, 0.0f, 0.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVTY), Zoom(ZOOM),
+	queuedX(0.0f), queuedY(0.0f), yawSin(0.0f), yawCos(1.0f), pitchSin(0.0f), pitchCos(1.0f), trigYaw(0.0f), trigPitch(0.0f) {
 	Position = position;
 	WorldUp = up;
 	Yaw = yaw;
@@ -8,7 +9,8 @@ Camera::Camera(glm::vec3 position, glm::vec3 up, float yaw, float pitch) : Front
 	updateCameraVectors();
 }
 
-Camera::Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(-1.0f, 0.0f, 0.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVTY), Zoom(ZOOM) {
+Camera::Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(-1.0f, 0.0f, 0.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVTY), Zoom(ZOOM),
+	queuedX(0.0f), queuedY(0.0f), yawSin(0.0f), yawCos(1.0f), pitchSin(0.0f), pitchCos(1.0f), trigYaw(0.0f), trigPitch(0.0f) {
 	Position = glm::vec3(posX, posY, posZ);
 	WorldUp = glm::vec3(upX, upY, upZ);
 	Yaw = yaw;
@@ -22,24 +24,33 @@ glm::mat4 Camera::GetViewMatrix() {
 
 void Camera::ProcessKeyboard(Camera_Movement direction, float deltaTime) {
 	float velocity = MovementSpeed * deltaTime;
-	glm::vec3 frontMovement = glm::normalize(Front - WorldUp * (Front * WorldUp));
-	glm::vec3 rightMovement = glm::normalize(Right - WorldUp * (Right * WorldUp));
+	// Right stays level, Heading is Front on the ground
 	if (direction == FORWARD)
-		Position += frontMovement * velocity;
+		Position += Heading * velocity;
 	if (direction == BACKWARD)
-		Position -= frontMovement * velocity;
+		Position -= Heading * velocity;
 	if (direction == LEFT)
-		Position -= rightMovement * velocity;
+		Position -= Right * velocity;
 	if (direction == RIGHT)
-		Position += rightMovement * velocity;
+		Position += Right * velocity;
 }
 
 void Camera::ProcessMouseMovement(float xoffset, float yoffset, GLboolean constrainPitch) {
-	xoffset *= MouseSensitivity;
-	yoffset *= MouseSensitivity;
+	QueueMouseMovement(xoffset, yoffset);
+	ApplyMouseMovement(constrainPitch);
+}
+
+void Camera::QueueMouseMovement(float xoffset, float yoffset) {
+	queuedX += xoffset;
+	queuedY += yoffset;
+}
 
-	Yaw += xoffset;
-	Pitch += yoffset;
+bool Camera::ApplyMouseMovement(GLboolean constrainPitch) {
+	if (queuedX == 0.0f && queuedY == 0.0f)
+		return false;
+	Yaw += queuedX * MouseSensitivity;
+	Pitch += queuedY * MouseSensitivity;
+	queuedX = queuedY = 0.0f;
 
 	// Make sure that when pitch is out of bounds, screen doesn't get flipped
 	if (constrainPitch)
@@ -52,6 +63,7 @@ void Camera::ProcessMouseMovement(float xoffset, float yoffset, GLboolean constr
 
 	// Update Front, Right and Up Vectors using the updated Eular angles
 	updateCameraVectors();
+	return true;
 }
 
 void Camera::ProcessMouseScroll(float yoffset) {
@@ -63,14 +75,39 @@ void Camera::ProcessMouseScroll(float yoffset) {
 		Zoom = 45.0f;
 }
 
+void Camera::SetFront(glm::vec3 front, glm::vec3 up) {
+	front = glm::normalize(front);
+	Pitch = glm::degrees(asin(glm::clamp(front.z, -1.0f, 1.0f)));
+	if (Pitch > 89.0f)
+		Pitch = 89.0f;
+	if (Pitch < -89.0f)
+		Pitch = -89.0f;
+	// of an upright camera front.xy * cos(pitch) - up.xy * sin(pitch) is the heading at any pitch, also where
+	// front.xy vanishes; without an up vector, looking straight up or down keeps the old yaw
+	glm::vec2 heading(front.x, front.y);
+	if (up.x != 0.0f || up.y != 0.0f || up.z != 0.0f)
+		heading = heading * up.z - glm::vec2(up.x, up.y) * front.z;
+	if (heading.x != 0.0f || heading.y != 0.0f)
+		Yaw = glm::degrees(atan2(heading.x, heading.y));
+	updateCameraVectors();
+}
+
 void Camera::updateCameraVectors() {
-	// Calculate the new Front vector
-	glm::vec3 front;
-	front.y = cos(glm::radians(Yaw)) * cos(glm::radians(Pitch));
-	front.z = sin(glm::radians(Pitch));
-	front.x = sin(glm::radians(Yaw)) * cos(glm::radians(Pitch));
-	Front = glm::normalize(front);
-	// Also re-calculate the Right and Up vector
-	Right = glm::normalize(glm::cross(Front, WorldUp));  // Normalize the vectors, because their length gets closer to 0 the more you look up or down which results in slower movement.
-	Up = glm::normalize(glm::cross(Right, Front));
+	// mouse movement mostly changes one of the angles, the sines of the other are kept
+	if (Yaw != trigYaw) {
+		yawSin = sin(glm::radians(Yaw));
+		yawCos = cos(glm::radians(Yaw));
+		trigYaw = Yaw;
+	}
+	if (Pitch != trigPitch) {
+		pitchSin = sin(glm::radians(Pitch));
+		pitchCos = cos(glm::radians(Pitch));
+		trigPitch = Pitch;
+	}
+	// The basis of yaw about the z axis followed by pitch about the level Right vector. It is orthonormal as
+	// written, without the cross products and normalizations that degenerate looking straight up or down
+	Heading = glm::vec3(yawSin, yawCos, 0.0f);
+	Front = glm::vec3(yawSin * pitchCos, yawCos * pitchCos, pitchSin);
+	Right = glm::vec3(yawCos, -yawSin, 0.0f);
+	Up = glm::vec3(-yawSin * pitchSin, -yawCos * pitchSin, pitchCos);
 }
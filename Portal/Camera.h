@@ -31,6 +31,7 @@ public:
 	glm::vec3 Front;
 	glm::vec3 Up;
 	glm::vec3 Right;
+	glm::vec3 Heading;		// Front flattened onto the ground, what walking forward follows
 	glm::vec3 WorldUp;
 	// Eular Angles
 	float Yaw;
@@ -55,11 +56,26 @@ public:
 	// Processes input received from a mouse input system. Expects the offset value in both the x and y direction.
 	void ProcessMouseMovement(float xoffset, float yoffset, GLboolean constrainPitch = true);
 
+	// Adds a mouse offset to those applied by the next ApplyMouseMovement(), so the mouse events of a frame turn the camera once
+	void QueueMouseMovement(float xoffset, float yoffset);
+	// Turns the camera by the offsets queued since the last call, returns whether there were any
+	bool ApplyMouseMovement(GLboolean constrainPitch = true);
+
 	// Processes input received from a mouse scroll-wheel event. Only requires input on the vertical wheel-axis
 	void ProcessMouseScroll(float yoffset);
 
+	// Turns the camera to look along front. The camera stays upright, a roll in front is dropped. Given the up
+	// vector turned along with front, the yaw follows the top of the screen when front is straight up or down
+	void SetFront(glm::vec3 front, glm::vec3 up = glm::vec3(0.0f));
+
 private:
-	// Calculates the front vector from the Camera's (updated) Eular Angles
+	// mouse offsets not applied yet
+	float queuedX, queuedY;
+	// sines of the angles the vectors were last calculated from, only the angles changed are recalculated
+	float yawSin, yawCos, pitchSin, pitchCos;
+	float trigYaw, trigPitch;
+
+	// Calculates the Front, Right, Up and Heading vectors from the Camera's (updated) Eular Angles
 	void updateCameraVectors();
 };
 
@@ -0,0 +1,54 @@
+#include "FrameArena.h"
+
+// overflow blocks keep the link to the previous block in front of the memory they hand out
+const size_t OVERFLOW_HEADER = 16;
+
+FrameArena::FrameArena(size_t capacity) : bufferSize(capacity), offset(0), overflow(NULL), overflowSize(0) {
+	buffer = new unsigned char[capacity];
+}
+
+FrameArena::~FrameArena() {
+	releaseOverflow();
+	delete[] buffer;
+}
+
+void *FrameArena::allocate(size_t size, size_t alignment) {
+	size_t start = (offset + alignment - 1) & ~(alignment - 1);
+	if (start + size <= bufferSize) {
+		offset = start + size;
+		return buffer + start;
+	}
+	unsigned char *block = new unsigned char[OVERFLOW_HEADER + size];
+	*(unsigned char **)block = overflow;
+	overflow = block;
+	overflowSize += size + alignment;
+	return block + OVERFLOW_HEADER;
+}
+
+void FrameArena::reset() {
+	if (overflow != NULL) {
+		releaseOverflow();
+		// make room for everything this frame needed
+		bufferSize = offset + overflowSize + bufferSize / 2;
+		delete[] buffer;
+		buffer = new unsigned char[bufferSize];
+		overflowSize = 0;
+	}
+	offset = 0;
+}
+
+size_t FrameArena::used() const {
+	return offset + overflowSize;
+}
+
+size_t FrameArena::capacity() const {
+	return bufferSize;
+}
+
+void FrameArena::releaseOverflow() {
+	while (overflow != NULL) {
+		unsigned char *previous = *(unsigned char **)overflow;
+		delete[] overflow;
+		overflow = previous;
+	}
+}
@@ -0,0 +1,36 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstddef>
+
+// Linear allocator for scratch memory that only lives until the end of the frame. Allocating bumps a
+// pointer and reset() releases everything at once. Requests that don't fit are served from the heap
+// and the arena grows to the peak usage at the next reset, so steady-state frames never touch the heap.
+class FrameArena {
+public:
+	FrameArena(size_t capacity);
+	~FrameArena();
+
+	void *allocate(size_t size, size_t alignment = 16);
+	template<typename T>
+	T *allocate(size_t count) {
+		return (T *)allocate(count * sizeof(T), alignof(T));
+	}
+	// releases all allocations of the frame
+	void reset();
+	size_t used() const;
+	size_t capacity() const;
+
+private:
+	unsigned char *buffer;
+	size_t bufferSize, offset;
+	unsigned char *overflow;	// heap blocks of this frame, linked through their first bytes
+	size_t overflowSize;
+
+	void releaseOverflow();
+	// not copyable
+	FrameArena(const FrameArena &);
+	FrameArena &operator=(const FrameArena &);
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "Frustum.h"
+
+#ifdef FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+void BoundsSoA::add(glm::vec3 boundsMin, glm::vec3 boundsMax) {
+	minX.push_back(boundsMin.x);
+	minY.push_back(boundsMin.y);
+	minZ.push_back(boundsMin.z);
+	maxX.push_back(boundsMax.x);
+	maxY.push_back(boundsMax.y);
+	maxZ.push_back(boundsMax.z);
+}
+
+void BoundsSoA::clear() {
+	minX.clear();
+	minY.clear();
+	minZ.clear();
+	maxX.clear();
+	maxY.clear();
+	maxZ.clear();
+}
+
+unsigned int BoundsSoA::size() const {
+	return minX.size();
+}
+
+Frustum::Frustum() : planeCount(0) {
+	//
+}
+
+void Frustum::extract(const glm::mat4 &viewProjection) {
+	// Gribb/Hartmann: each plane is the last row of the matrix plus or minus one of the others
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; ++i) {
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+	}
+	planeCount = 0;
+	for (int i = 0; i < 3; ++i) {
+		addPlane(rows[3] + rows[i]);
+		addPlane(rows[3] - rows[i]);
+	}
+}
+
+void Frustum::addPlane(glm::vec4 plane) {
+	if (planeCount >= MAX_FRUSTUM_PLANES) {
+		return;
+	}
+	float length = glm::length(glm::vec3(plane));
+	planes[planeCount++] = (length > 0.0f) ? plane / length : plane;
+}
+
+bool Frustum::isBoxVisible(glm::vec3 boundsMin, glm::vec3 boundsMax) const {
+	for (int i = 0; i < planeCount; ++i) {
+		// the box corner furthest along the plane normal
+		glm::vec3 p(planes[i].x >= 0.0f ? boundsMax.x : boundsMin.x,
+			planes[i].y >= 0.0f ? boundsMax.y : boundsMin.y,
+			planes[i].z >= 0.0f ? boundsMax.z : boundsMin.z);
+		if (glm::dot(glm::vec3(planes[i]), p) + planes[i].w < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int Frustum::cullBoxes(const BoundsSoA &bounds, unsigned char *visible) const {
+	unsigned int count = bounds.size();
+	unsigned int i = 0;
+	int visibleCount = 0;
+#ifdef FRUSTUM_SSE
+	for (; i + 4 <= count; i += 4) {
+		__m128 outside = _mm_setzero_ps();
+		for (int j = 0; j < planeCount; ++j) {
+			const glm::vec4 &plane = planes[j];
+			__m128 px = _mm_loadu_ps(plane.x >= 0.0f ? &bounds.maxX[i] : &bounds.minX[i]);
+			__m128 py = _mm_loadu_ps(plane.y >= 0.0f ? &bounds.maxY[i] : &bounds.minY[i]);
+			__m128 pz = _mm_loadu_ps(plane.z >= 0.0f ? &bounds.maxZ[i] : &bounds.minZ[i]);
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(plane.x)), _mm_mul_ps(py, _mm_set1_ps(plane.y))),
+				_mm_add_ps(_mm_mul_ps(pz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+		}
+		int mask = _mm_movemask_ps(outside);
+		for (int k = 0; k < 4; ++k) {
+			visible[i + k] = ((mask >> k) & 1) ? 0 : 1;
+			visibleCount += visible[i + k];
+		}
+	}
+#endif
+	for (; i < count; ++i) {
+		visible[i] = isBoxVisible(glm::vec3(bounds.minX[i], bounds.minY[i], bounds.minZ[i]), glm::vec3(bounds.maxX[i], bounds.maxY[i], bounds.maxZ[i])) ? 1 : 0;
+		visibleCount += visible[i];
+	}
+	return visibleCount;
+}
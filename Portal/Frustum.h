@@ -0,0 +1,46 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+using namespace std;
+
+#if defined(_M_X64) || defined(_M_IX86_FP) || defined(__SSE__)
+#define FRUSTUM_SSE
+#endif
+
+// 6 planes of the view frustum plus the planes of the portal a remote view looks through
+#define MAX_FRUSTUM_PLANES 12
+
+// axis aligned boxes stored as separate coordinate arrays, so four boxes can be tested at once
+struct BoundsSoA {
+	vector<float> minX, minY, minZ;
+	vector<float> maxX, maxY, maxZ;
+
+	void add(glm::vec3 boundsMin, glm::vec3 boundsMax);
+	void clear();
+	unsigned int size() const;
+};
+
+// A convex volume bounded by planes whose normals point inside.
+class Frustum {
+public:
+	glm::vec4 planes[MAX_FRUSTUM_PLANES];
+	int planeCount;
+
+public:
+	Frustum();
+
+	// extracts the six planes of a view-projection matrix, replacing all planes
+	void extract(const glm::mat4 &viewProjection);
+	// adds another bounding plane, like the exit plane of a portal
+	void addPlane(glm::vec4 plane);
+
+	bool isBoxVisible(glm::vec3 boundsMin, glm::vec3 boundsMax) const;
+	// writes 1 to visible[i] for every box intersecting the volume, 0 otherwise, returns the number of visible boxes
+	int cullBoxes(const BoundsSoA &bounds, unsigned char *visible) const;
+};
+
+#endif
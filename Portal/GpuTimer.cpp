@@ -0,0 +1,33 @@
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer() : milliseconds(0.0f), current(0) {
+	for (int i = 0; i < GPU_TIMER_FRAMES; ++i) {
+		queries[i] = 0;
+		pending[i] = false;
+	}
+}
+
+GpuTimer::~GpuTimer() {
+	//
+}
+
+void GpuTimer::initialize() {
+	glGenQueries(GPU_TIMER_FRAMES, queries);
+}
+
+void GpuTimer::begin() {
+	// collect the result of the query issued GPU_TIMER_FRAMES frames ago before reusing it
+	if (pending[current]) {
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(queries[current], GL_QUERY_RESULT, &elapsed);
+		milliseconds = milliseconds.load() * 0.9f + (elapsed / 1000000.0f) * 0.1f;
+		pending[current] = false;
+	}
+	glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+}
+
+void GpuTimer::end() {
+	glEndQuery(GL_TIME_ELAPSED);
+	pending[current] = true;
+	current = (current + 1) % GPU_TIMER_FRAMES;
+}
@@ -0,0 +1,32 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <glad/glad.h>
+
+#include <atomic>
+
+// number of frames a query result may lag behind, so reading it never stalls the pipeline
+#define GPU_TIMER_FRAMES 3
+
+// Measures the GPU time spent between begin() and end() with GL_TIME_ELAPSED queries.
+// Results arrive a few frames late and are smoothed over time; they are read from other threads than the
+// one issuing the queries.
+class GpuTimer {
+public:
+	std::atomic<float> milliseconds;
+
+public:
+	GpuTimer();
+	~GpuTimer();
+
+	void initialize();
+	void begin();
+	void end();
+
+private:
+	unsigned int queries[GPU_TIMER_FRAMES];
+	bool pending[GPU_TIMER_FRAMES];
+	int current;
+};
+
+#endif
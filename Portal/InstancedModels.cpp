@@ -0,0 +1,150 @@
+#include "InstancedModels.h"
+
+#include <algorithm>
+
+// the instance transform takes the four attribute locations from this one on
+const int INSTANCE_ATTRIBUTE = 6;
+
+InstancedModels::InstancedModels() : VAO(0), VBO(0), EBO(0), instanceVBO(0), indexType(GL_UNSIGNED_INT), instanceCount(0), capacity(0), largestMesh(0) {
+	//
+}
+
+InstancedModels::~InstancedModels() {
+	//
+}
+
+int InstancedModels::add(const Model &model) {
+	ModelRange range;
+	range.firstMesh = (int)meshes.size();
+	range.meshCount = (int)model.meshes.size();
+	range.firstInstance = range.instanceCount = 0;
+	for (unsigned int i = 0; i < model.meshes.size(); i++) {
+		const Mesh &mesh = model.meshes[i];
+		MeshRange mr;
+		mr.baseVertex = (int)vertices.size();
+		mr.firstIndex = (unsigned int)indices.size();
+		mr.indexCount = (unsigned int)mesh.indices.size();
+		mr.texture = 0;
+		const Material *material = model.materialOf(mesh);
+		const vector<Texture> &textures = (material != NULL) ? material->textures : mesh.textures;
+		for (unsigned int j = 0; j < textures.size(); j++) {
+			if (textures[j].type == TEXTURE_DIFFUSE) {
+				mr.texture = textures[j].id;
+				break;
+			}
+		}
+		largestMesh = max(largestMesh, (int)mesh.vertices.size());
+		vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+		indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+		meshes.push_back(mr);
+	}
+	// meshes sharing a texture are drawn one after another, so it is bound once for them
+	stable_sort(meshes.begin() + range.firstMesh, meshes.end(), [](const MeshRange &a, const MeshRange &b) {
+		return a.texture < b.texture;
+	});
+	models.push_back(range);
+	return (int)models.size() - 1;
+}
+
+int InstancedModels::modelCount() const {
+	return (int)models.size();
+}
+
+void InstancedModels::initialize() {
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glGenBuffers(1, &EBO);
+	glGenBuffers(1, &instanceVBO);
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.empty() ? NULL : &vertices[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	indexType = uploadIndices(indices, largestMesh <= 65536);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+	// the transform of the instance, a column per attribute; Draw points them at the instances of each model
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	for (int c = 0; c < 4; ++c) {
+		glEnableVertexAttribArray(INSTANCE_ATTRIBUTE + c);
+		glVertexAttribPointer(INSTANCE_ATTRIBUTE + c, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(c * sizeof(glm::vec4)));
+		glVertexAttribDivisor(INSTANCE_ATTRIBUTE + c, 1);
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	// the GPU holds its own copy now
+	vector<Vertex>().swap(vertices);
+	vector<unsigned int>().swap(indices);
+}
+
+void InstancedModels::upload(const ModelInstance *instances, int count) {
+	// counting sort by model, each model draws a contiguous range of the instance buffer
+	for (unsigned int m = 0; m < models.size(); m++) {
+		models[m].instanceCount = 0;
+	}
+	instanceCount = 0;
+	for (int i = 0; i < count; ++i) {
+		if (instances[i].model >= 0 && instances[i].model < (int)models.size()) {
+			++models[instances[i].model].instanceCount;
+			++instanceCount;
+		}
+	}
+	if (instanceCount == 0) {
+		return;
+	}
+	int first = 0;
+	for (unsigned int m = 0; m < models.size(); m++) {
+		models[m].firstInstance = first;
+		first += models[m].instanceCount;
+		// counts the instances placed again below
+		models[m].instanceCount = 0;
+	}
+	transforms.resize(instanceCount);
+	for (int i = 0; i < count; ++i) {
+		if (instances[i].model >= 0 && instances[i].model < (int)models.size()) {
+			ModelRange &model = models[instances[i].model];
+			transforms[model.firstInstance + model.instanceCount++] = instances[i].transform;
+		}
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	if (instanceCount > capacity) {
+		capacity = max(instanceCount, capacity * 2);
+		glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), NULL, GL_DYNAMIC_DRAW);
+	}
+	glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * sizeof(glm::mat4), &transforms[0]);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstancedModels::Draw(Shader shader) {
+	if (instanceCount == 0) {
+		return;
+	}
+	shader.setInt("texture_diffuse", 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	unsigned int bound = 0;
+	for (unsigned int m = 0; m < models.size(); m++) {
+		const ModelRange &model = models[m];
+		if (model.instanceCount == 0) {
+			continue;
+		}
+		// GL 3.3 has no base instance, the instance attributes start at the model's range instead
+		for (int c = 0; c < 4; ++c) {
+			glVertexAttribPointer(INSTANCE_ATTRIBUTE + c, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(model.firstInstance * sizeof(glm::mat4) + c * sizeof(glm::vec4)));
+		}
+		for (int i = model.firstMesh; i < model.firstMesh + model.meshCount; ++i) {
+			const MeshRange &mesh = meshes[i];
+			if (mesh.texture != bound) {
+				glBindTexture(GL_TEXTURE_2D, mesh.texture);
+				bound = mesh.texture;
+			}
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh.indexCount, indexType, (void*)(size_t)(mesh.firstIndex * (indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int))), model.instanceCount, mesh.baseVertex);
+		}
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
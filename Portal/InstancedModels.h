@@ -0,0 +1,64 @@
+#ifndef INSTANCED_MODELS_H
+#define INSTANCED_MODELS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "Shader.h"
+#include "Model.h"
+
+using namespace std;
+
+// one placed copy of a model added to InstancedModels
+struct ModelInstance {
+	int model;
+	glm::mat4 transform;
+};
+
+// Draws any number of copies of Assimp models with one instanced draw per mesh. The meshes of all models
+// share one vertex and one index buffer, so drawing never switches vertex arrays, and the transforms of the
+// instances are grouped by model in an instance buffer that every view of a frame draws from.
+class InstancedModels {
+public:
+	unsigned int VAO, VBO, EBO, instanceVBO;
+	GLenum indexType;	// indices count from the base vertex of their mesh, so they are 16-bit while every mesh allows
+	int instanceCount;
+
+public:
+	InstancedModels();
+	~InstancedModels();
+
+	// copies the meshes of model and returns the id its instances are placed with, models are added before initialize()
+	int add(const Model &model);
+	int modelCount() const;
+	// uploads the meshes of all models added
+	void initialize();
+	// replaces the instances drawn by count instances, in any order
+	void upload(const ModelInstance *instances, int count);
+	// draws all instances with the INSTANCED permutation of shader_scene for the transformations set on shader
+	void Draw(Shader shader);
+
+private:
+	struct MeshRange {
+		int baseVertex;
+		unsigned int firstIndex;
+		unsigned int indexCount;
+		unsigned int texture;	// the first diffuse texture, 0 without one
+	};
+	struct ModelRange {
+		int firstMesh, meshCount;
+		int firstInstance, instanceCount;
+	};
+	vector<MeshRange> meshes;
+	vector<ModelRange> models;
+	vector<Vertex> vertices;		// released once uploaded
+	vector<unsigned int> indices;
+	vector<glm::mat4> transforms;	// the instances grouped by model
+	int capacity;
+	int largestMesh;		// vertices of the largest mesh added
+};
+
+#endif
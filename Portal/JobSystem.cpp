@@ -0,0 +1,148 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+// queue of the running thread, the thread that initialized the system owns queue 0
+static thread_local int currentQueue = 0;
+
+JobSystem::JobSystem() : queues(NULL), queueCount(0), stopping(false), queued(0) {
+	//
+}
+
+JobSystem::~JobSystem() {
+	stopping = true;
+	{
+		lock_guard<mutex> guard(sleepLock);
+		wake.notify_all();
+	}
+	for (size_t i = 0; i < threads.size(); ++i) {
+		threads[i].join();
+	}
+	delete[] queues;
+}
+
+void JobSystem::initialize(int threadCount) {
+	if (threadCount < 0) {
+		threadCount = max(1, (int)thread::hardware_concurrency()) - 1;
+	}
+	queueCount = threadCount + 1;
+	queues = new Queue[queueCount];
+	for (int i = 0; i < queueCount; ++i) {
+		queues[i].head = queues[i].tail = 0;
+	}
+	currentQueue = 0;
+	for (int i = 1; i < queueCount; ++i) {
+		threads.push_back(thread(&JobSystem::workerLoop, this, i));
+	}
+}
+
+int JobSystem::threadCount() const {
+	return max(1, queueCount);
+}
+
+void JobSystem::run(JobFunction function, void *data, int begin, int end, JobCounter &counter) {
+	Job job = { function, data, begin, end, &counter };
+	counter.pending.fetch_add(1);
+	if (queueCount == 0) {
+		execute(job);
+		return;
+	}
+	Queue &queue = queues[currentQueue];
+	{
+		lock_guard<mutex> guard(queue.lock);
+		if (queue.tail == queue.head) {
+			queue.head = queue.tail = 0;
+		}
+		if (queue.tail - queue.head < JOB_QUEUE_SIZE) {
+			queue.jobs[queue.tail % JOB_QUEUE_SIZE] = job;
+			++queue.tail;
+			job.function = NULL;
+		}
+	}
+	if (job.function != NULL) {
+		execute(job);
+		return;
+	}
+	queued.fetch_add(1);
+	// taking the lock orders the notification after a sleeping worker checked queued
+	lock_guard<mutex> guard(sleepLock);
+	wake.notify_one();
+}
+
+void JobSystem::wait(JobCounter &counter) {
+	while (counter.pending.load() > 0) {
+		if (queueCount == 0 || !runOne(currentQueue)) {
+			this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::parallelFor(int count, int grain, JobFunction function, void *data) {
+	if (count <= 0) {
+		return;
+	}
+	// a few ranges per thread, so threads finishing early find more to steal
+	int ranges = min((count + grain - 1) / max(1, grain), threadCount() * 4);
+	if (ranges <= 1 || queueCount <= 1) {
+		function(data, 0, count);
+		return;
+	}
+	JobCounter counter;
+	for (int i = 0; i < ranges; ++i) {
+		run(function, data, (int)((long long)count * i / ranges), (int)((long long)count * (i + 1) / ranges), counter);
+	}
+	wait(counter);
+}
+
+bool JobSystem::pop(int self, Job &job) {
+	Queue &queue = queues[self];
+	lock_guard<mutex> guard(queue.lock);
+	if (queue.tail == queue.head) {
+		return false;
+	}
+	// newest first, its data is most likely still in the cache
+	--queue.tail;
+	job = queue.jobs[queue.tail % JOB_QUEUE_SIZE];
+	return true;
+}
+
+bool JobSystem::steal(int self, Job &job) {
+	for (int i = 1; i < queueCount; ++i) {
+		Queue &queue = queues[(self + i) % queueCount];
+		lock_guard<mutex> guard(queue.lock);
+		if (queue.tail == queue.head) {
+			continue;
+		}
+		// oldest first, it is usually the largest piece of work left
+		job = queue.jobs[queue.head % JOB_QUEUE_SIZE];
+		++queue.head;
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::runOne(int self) {
+	Job job;
+	if (!pop(self, job) && !steal(self, job)) {
+		return false;
+	}
+	queued.fetch_sub(1);
+	execute(job);
+	return true;
+}
+
+void JobSystem::execute(const Job &job) {
+	job.function(job.data, job.begin, job.end);
+	job.counter->pending.fetch_sub(1);
+}
+
+void JobSystem::workerLoop(int self) {
+	currentQueue = self;
+	while (!stopping) {
+		if (runOne(self)) {
+			continue;
+		}
+		unique_lock<mutex> guard(sleepLock);
+		wake.wait(guard, [this]() { return stopping || queued.load() > 0; });
+	}
+}
@@ -0,0 +1,79 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// jobs one thread can have queued, a thread with a full queue runs the job it is given right away
+#define JOB_QUEUE_SIZE 256
+
+// a job works on the items begin to end of data
+typedef void (*JobFunction)(void *data, int begin, int end);
+
+// jobs of a group still running, wait() returns once it drops to zero
+struct JobCounter {
+	atomic<int> pending;
+
+	JobCounter() : pending(0) {}
+};
+
+struct Job {
+	JobFunction function;
+	void *data;
+	int begin, end;
+	JobCounter *counter;
+};
+
+// Work-stealing thread pool. Every thread, the one that called initialize() included, has its own queue:
+// it pushes and pops jobs at the back of it, idle threads steal from the front of the others. Waiting on a
+// counter runs queued jobs instead of blocking, so jobs may start and wait for jobs of their own.
+// Jobs are plain function pointers over ranges, queuing and running them never touches the heap.
+class JobSystem {
+public:
+	JobSystem();
+	~JobSystem();
+
+	// starts threadCount worker threads, by default one per core besides the calling thread
+	void initialize(int threadCount = -1);
+	// threads running jobs, the calling thread included
+	int threadCount() const;
+
+	// queues function over the items begin to end, counter counts it until it has run
+	void run(JobFunction function, void *data, int begin, int end, JobCounter &counter);
+	// runs jobs until all counted by counter have finished
+	void wait(JobCounter &counter);
+	// runs function over the items 0 to count split into ranges of at least grain items over all threads
+	// and returns when all of them are done; without worker threads it runs all of them right here
+	void parallelFor(int count, int grain, JobFunction function, void *data);
+
+private:
+	struct Queue {
+		mutex lock;
+		Job jobs[JOB_QUEUE_SIZE];
+		int head, tail;		// jobs[head % size] up to jobs[tail % size]
+	};
+	Queue *queues;
+	int queueCount;
+	vector<thread> threads;
+	atomic<bool> stopping;
+	atomic<int> queued;		// jobs in all queues
+	mutex sleepLock;
+	condition_variable wake;
+
+	bool pop(int self, Job &job);
+	bool steal(int self, Job &job);
+	// runs one job of the own queue or stolen from another, returns false if there was none
+	bool runOne(int self);
+	void execute(const Job &job);
+	void workerLoop(int self);
+	// not copyable
+	JobSystem(const JobSystem &);
+	JobSystem &operator=(const JobSystem &);
+};
+
+#endif
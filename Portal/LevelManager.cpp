@@ -0,0 +1,90 @@
+#include "LevelManager.h"
+#include "AllocationCounter.h"
+
+LevelManager::LevelManager() : current(0), scene(NULL), nextState(NEXT_NONE), next(0), loaded(false), nextScene(NULL), nextPhysics(NULL), retired(NULL) {
+	//
+}
+
+LevelManager::~LevelManager() {
+	if (loader.joinable()) {
+		loader.join();
+	}
+	// the GL objects go with the context
+	delete scene;
+	delete nextScene;
+	delete nextPhysics;
+	delete retired;
+}
+
+bool LevelManager::load(const string &listPath) {
+	ifstream inFile(listPath);
+	if (!inFile) {
+		std::cout << "Level list failed to load at path: " << listPath << std::endl;
+		return false;
+	}
+	Level level;
+	while (inFile >> level.mapPath >> level.winPath >> level.start.x >> level.start.y >> level.start.z) {
+		levels.push_back(level);
+	}
+	if (levels.empty()) {
+		std::cout << "Level list has no levels: " << listPath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+const Level &LevelManager::level() const {
+	return levels[current];
+}
+
+void LevelManager::start(int index, Physics &physics) {
+	current = index;
+	scene = new Model(levels[current].mapPath);
+	physics = Physics(levels[current].mapPath, levels[current].winPath, glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+void LevelManager::update(RenderCommandList &commands) {
+	if (retired != NULL) {
+		commands.releaseModel(retired);
+		retired = NULL;
+	}
+	if (nextState == NEXT_NONE && !levels.empty()) {
+		next = (current + 1) % (int)levels.size();
+		loaded = false;
+		loader = thread(&LevelManager::loadNext, this);
+		nextState = NEXT_LOADING;
+	}
+	else if (nextState == NEXT_LOADING && loaded.load()) {
+		loader.join();
+		// the draws of the level come after the upload in the lists replayed
+		commands.uploadModel(nextScene);
+		nextState = NEXT_READY;
+	}
+}
+
+bool LevelManager::nextReady() const {
+	return nextState == NEXT_READY;
+}
+
+void LevelManager::advance(Physics &physics) {
+	if (nextState != NEXT_READY) {
+		return;
+	}
+	retired = scene;
+	scene = nextScene;
+	physics = move(*nextPhysics);
+	delete nextPhysics;
+	nextScene = NULL;
+	nextPhysics = NULL;
+	current = next;
+	nextState = NEXT_NONE;
+}
+
+void LevelManager::loadNext() {
+	// loading allocates plenty, none of it belongs to the frames running meanwhile
+	ignoreThreadAllocations();
+	const Level &level = levels[next];
+	nextScene = new Model(level.mapPath, false, true);
+	nextPhysics = new Physics(level.mapPath, level.winPath, glm::vec3(0.0f, 0.0f, 1.0f));
+	loaded = true;
+}
@@ -0,0 +1,66 @@
+#ifndef LEVEL_MANAGER_H
+#define LEVEL_MANAGER_H
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include "Model.h"
+#include "Physics.h"
+#include "RenderCommands.h"
+
+using namespace std;
+
+struct Level {
+	string mapPath;
+	string winPath;
+	glm::vec3 start;	// where the eye starts
+};
+
+// The levels, played one after the other and from the first again after the last. While a level is played
+// the map and the physics of the next one are loaded on a thread of their own, without touching GL, and the
+// render thread uploads the map as soon as it is loaded. Reaching the win point then swaps the levels between
+// two frames, and the render thread releases the old map after the last frame that draws it.
+class LevelManager {
+public:
+	vector<Level> levels;
+	int current;
+	Model *scene;		// map of the level played
+
+public:
+	LevelManager();
+	~LevelManager();
+
+	// reads the level list, a line of map file, win file and start position per level
+	bool load(const string &listPath);
+	const Level &level() const;
+	// loads level index right away into scene and physics, on the thread owning the GL context
+	void start(int index, Physics &physics);
+	// on the game thread once per frame: starts loading the next level, records the upload of a loaded one
+	// and the release of a map swapped out
+	void update(RenderCommandList &commands);
+	// whether the next level is loaded and its upload recorded
+	bool nextReady() const;
+	// makes the next level the one played, its physics are moved into physics; call between frames
+	void advance(Physics &physics);
+
+private:
+	enum NextState { NEXT_NONE, NEXT_LOADING, NEXT_READY };
+	NextState nextState;
+	int next;
+	thread loader;
+	atomic<bool> loaded;		// the loader is done with nextScene and nextPhysics
+	Model *nextScene;
+	Physics *nextPhysics;
+	Model *retired;				// swapped out, released through the next list recorded
+
+	void loadNext();
+	// not copyable
+	LevelManager(const LevelManager &);
+	LevelManager &operator=(const LevelManager &);
+};
+
+#endif
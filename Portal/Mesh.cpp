@@ -1,49 +1,97 @@
 #include "Mesh.h"
 
-Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures) {
+#include <algorithm>
+
+GLenum uploadIndices(const vector<unsigned int> &indices, bool shortIndices) {
+	if (!shortIndices) {
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.empty() ? NULL : &indices[0], GL_STATIC_DRAW);
+		return GL_UNSIGNED_INT;
+	}
+	// half the index memory and bandwidth, the CPU copy keeps 32 bits
+	vector<unsigned short> shortened(indices.begin(), indices.end());
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortened.size() * sizeof(unsigned short), shortened.empty() ? NULL : &shortened[0], GL_STATIC_DRAW);
+	return GL_UNSIGNED_SHORT;
+}
+
+Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, int material, bool deferUpload) : VAO(0), indexType(GL_UNSIGNED_INT), VBO(0), EBO(0) {
 	this->vertices = vertices;
 	this->indices = indices;
 	this->textures = textures;
+	this->material = material;
 
 	// now that we have all the required data, set the vertex buffers and its attribute pointers.
-	setupMesh();
+	if (!deferUpload)
+		setupMesh();
 }
 
-void Mesh::Draw(Shader shader) {
-	// bind appropriate textures
-	unsigned int diffuseNr = 1;
-	unsigned int specularNr = 1;
-	unsigned int normalNr = 1;
-	unsigned int heightNr = 1;
-	for (unsigned int i = 0; i < textures.size(); i++) 	{
-		glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-										  // retrieve texture number (the N in diffuse_textureN)
-		string number;
-		string name = textures[i].type;
-		if (name == "texture_diffuse")
-			number = std::to_string(diffuseNr++);
-		else if (name == "texture_specular")
-			number = std::to_string(specularNr++); // transfer unsigned int to stream
-		else if (name == "texture_normal")
-			number = std::to_string(normalNr++); // transfer unsigned int to stream
-		else if (name == "texture_height")
-			number = std::to_string(heightNr++); // transfer unsigned int to stream
-
-												 // now set the sampler to the correct texture unit
-		glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-		// and finally bind the texture
-		glBindTexture(GL_TEXTURE_2D, textures[i].id);
-	}
+void Mesh::Draw(Shader shader, const Material *material) {
+	bindTextures(shader, material);
 
 	// draw mesh
 	glBindVertexArray(VAO);
-	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+	glDrawElements(GL_TRIANGLES, indices.size(), indexType, 0);
 	glBindVertexArray(0);
 
 	// always good practice to set everything back to defaults once configured.
 	glActiveTexture(GL_TEXTURE0);
 }
 
+void Mesh::DrawInstanced(Shader shader, int instances, const Material *material) {
+	bindTextures(shader, material);
+
+	glBindVertexArray(VAO);
+	glDrawElementsInstanced(GL_TRIANGLES, indices.size(), indexType, 0, instances);
+	glBindVertexArray(0);
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+int Mesh::indexSize() const {
+	return (indexType == GL_UNSIGNED_SHORT) ? sizeof(unsigned short) : sizeof(unsigned int);
+}
+
+void Mesh::DrawRanges(Shader shader, const GLsizei *counts, const void * const *offsets, int drawCount, const Material *material) {
+	bindTextures(shader, material);
+
+	glBindVertexArray(VAO);
+	glMultiDrawElements(GL_TRIANGLES, counts, indexType, offsets, drawCount);
+	glBindVertexArray(0);
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+// the samplers of each texture type are named texture_diffuse1, texture_diffuse2, ... up to the last name
+// of the row, which further textures of the type share; the texture array has a single sampler
+const int MAX_SAMPLERS_PER_TYPE = 4;
+static const char *samplerNames[TEXTURE_TYPE_COUNT][MAX_SAMPLERS_PER_TYPE] = {
+	{ "texture_diffuse1", "texture_diffuse2", "texture_diffuse3", "texture_diffuse4" },
+	{ "texture_specular1", "texture_specular2", "texture_specular3", "texture_specular4" },
+	{ "texture_normal1", "texture_normal2", "texture_normal3", "texture_normal4" },
+	{ "texture_height1", "texture_height2", "texture_height3", "texture_height4" },
+	{ "texture_array", "texture_array", "texture_array", "texture_array" }
+};
+
+void Mesh::bindTextures(Shader shader, const Material *material) {
+	const vector<Texture> &textures = (material != NULL) ? material->textures : this->textures;
+	int numbers[TEXTURE_TYPE_COUNT] = { 0 };
+	for (unsigned int i = 0; i < textures.size(); i++) 	{
+		glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
+		// now set the sampler to the correct texture unit
+		TextureType type = textures[i].type;
+		int number = min(numbers[type]++, MAX_SAMPLERS_PER_TYPE - 1);
+		glUniform1i(glGetUniformLocation(shader.ID, samplerNames[type][number]), i);
+		// and finally bind the texture
+		glBindTexture(type == TEXTURE_ARRAY ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D, textures[i].id);
+	}
+}
+
+void Mesh::release() {
+	glDeleteVertexArrays(1, &VAO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(1, &EBO);
+	VAO = VBO = EBO = 0;
+}
+
 void Mesh::setupMesh() {
 	// create buffers/arrays
 	glGenVertexArrays(1, &VAO);
@@ -56,10 +104,10 @@ void Mesh::setupMesh() {
 	// A great thing about structs is that their memory layout is sequential for all its items.
 	// The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
 	// again translates to 3/2 floats which translates to a byte array.
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.empty() ? NULL : &vertices[0], GL_STATIC_DRAW);
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+	indexType = uploadIndices(indices, vertices.size() <= 65536);
 
 	// set the vertex attribute pointers
 	// vertex Positions
@@ -77,6 +125,9 @@ void Mesh::setupMesh() {
 	// vertex bitangent
 	glEnableVertexAttribArray(4);
 	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+	// vertex texture array layer
+	glEnableVertexAttribArray(5);
+	glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexLayer));
 
 	glBindVertexArray(0);
 }
@@ -27,36 +27,69 @@ struct Vertex {
 	glm::vec3 Tangent;
 	// bitangent
 	glm::vec3 Bitangent;
+	// texture array layer
+	float TexLayer;
 };
 
+// what a texture is bound as, the samplers of each type are numbered on their own
+enum TextureType {
+	TEXTURE_DIFFUSE,
+	TEXTURE_SPECULAR,
+	TEXTURE_NORMAL,
+	TEXTURE_HEIGHT,
+	TEXTURE_ARRAY,
+	TEXTURE_TYPE_COUNT
+};
+
+// a loaded texture as meshes bind it, the path it was loaded from stays with the Model that interned it
 struct Texture {
 	unsigned int id;
-	string type;
-	string path;
+	TextureType type;
+};
+
+// the textures of a material, the meshes using it refer to it by its index in the model
+struct Material {
+	vector<Texture> textures;
 };
 
+// uploads indices to the bound element array buffer, as 16-bit indices if short, and returns their GL type
+GLenum uploadIndices(const vector<unsigned int> &indices, bool shortIndices);
+
 class Mesh {
 public:
 	/*  Mesh Data  */
 	vector<Vertex> vertices;
 	vector<unsigned int> indices;
-	vector<Texture> textures;
+	vector<Texture> textures;	// of a mesh without a material, like the map and the portals
+	int material;		// index of the material of the model the textures come from, -1 if none
 	unsigned int VAO;
+	GLenum indexType;	// 16-bit indices when the vertices allow, 32-bit otherwise
 
 	/*  Functions  */
-	// constructor
-	Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures);
+	// constructor, the buffers are set up right away unless deferUpload
+	Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, int material = -1, bool deferUpload = false);
+
+	// initializes all the buffer objects/arrays
+	void setupMesh();
+	// deletes them again, the textures belong to the model
+	void release();
 
-	// render the mesh
-	void Draw(Shader shader);
+	// render the mesh with the textures of its material, its own if material is NULL
+	void Draw(Shader shader, const Material *material = NULL);
+	// render the mesh once per instance, the shader picks its view with gl_InstanceID
+	void DrawInstanced(Shader shader, int instances, const Material *material = NULL);
+	// bytes per index in the element buffer, offsets of DrawRanges are counted in them
+	int indexSize() const;
+	// render several index ranges of the mesh with one glMultiDrawElements call
+	void DrawRanges(Shader shader, const GLsizei *counts, const void * const *offsets, int drawCount, const Material *material = NULL);
 
 private:
 	/*  Render data  */
 	unsigned int VBO, EBO;
 
 	/*  Functions    */
-	// initializes all the buffer objects/arrays
-	void setupMesh();
+	// binds the textures to sequential units and points the samplers at them
+	void bindTextures(Shader shader, const Material *material);
 };
 
 #endif
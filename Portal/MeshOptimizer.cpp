@@ -0,0 +1,213 @@
+#include "MeshOptimizer.h"
+
+#include <cstring>
+#include <algorithm>
+
+// FNV-1a over the bytes of the vertex
+static unsigned int hashVertex(const Vertex &vertex) {
+	const unsigned char *bytes = (const unsigned char *)&vertex;
+	unsigned int hash = 2166136261u;
+	for (size_t i = 0; i < sizeof(Vertex); ++i) {
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	return hash;
+}
+
+int weldVertices(vector<Vertex> &vertices, vector<unsigned int> &indices) {
+	// open addressing over the vertices kept, at most half full
+	unsigned int tableSize = 1;
+	while (tableSize < vertices.size() * 2) {
+		tableSize *= 2;
+	}
+	vector<int> table(tableSize, -1);
+	vector<unsigned int> remap(vertices.size());
+	vector<Vertex> welded;
+	welded.reserve(vertices.size());
+	vector<unsigned char> used(vertices.size(), 0);
+	for (unsigned int i = 0; i < indices.size(); ++i) {
+		used[indices[i]] = 1;
+	}
+	for (unsigned int v = 0; v < vertices.size(); ++v) {
+		if (!used[v]) {
+			continue;
+		}
+		unsigned int slot = hashVertex(vertices[v]) & (tableSize - 1);
+		while (table[slot] >= 0 && memcmp(&welded[table[slot]], &vertices[v], sizeof(Vertex)) != 0) {
+			slot = (slot + 1) & (tableSize - 1);
+		}
+		if (table[slot] < 0) {
+			table[slot] = (int)welded.size();
+			welded.push_back(vertices[v]);
+		}
+		remap[v] = (unsigned int)table[slot];
+	}
+	for (unsigned int i = 0; i < indices.size(); ++i) {
+		indices[i] = remap[indices[i]];
+	}
+	vertices.swap(welded);
+	return (int)vertices.size();
+}
+
+// the next vertex to fan around: the candidate whose triangles will still find it in the cache, or else
+// one with triangles left from the dead-end stack or the input order, -1 once all triangles are out
+static int nextVertex(int &cursor, int vertexCount, const vector<int> &candidates, const vector<int> &cacheTime, int time,
+	const vector<int> &liveTriangles, vector<int> &deadEnds) {
+	int best = -1, bestPriority = -1;
+	for (unsigned int i = 0; i < candidates.size(); ++i) {
+		int v = candidates[i];
+		if (liveTriangles[v] <= 0) {
+			continue;
+		}
+		int priority = 0;
+		// it is in the cache and stays there while its remaining triangles go out
+		if (time - cacheTime[v] + 2 * liveTriangles[v] <= VERTEX_CACHE_SIZE) {
+			priority = time - cacheTime[v];
+		}
+		if (priority > bestPriority) {
+			best = v;
+			bestPriority = priority;
+		}
+	}
+	if (best >= 0) {
+		return best;
+	}
+	while (!deadEnds.empty()) {
+		int v = deadEnds.back();
+		deadEnds.pop_back();
+		if (liveTriangles[v] > 0) {
+			return v;
+		}
+	}
+	while (cursor < vertexCount) {
+		if (liveTriangles[cursor] > 0) {
+			return cursor;
+		}
+		++cursor;
+	}
+	return -1;
+}
+
+void optimizeVertexCache(unsigned int *indices, int count, int vertexCount) {
+	int triangles = count / 3;
+	if (triangles < 2) {
+		return;
+	}
+	// the triangles around every vertex
+	vector<int> liveTriangles(vertexCount, 0);
+	for (int i = 0; i < triangles * 3; ++i) {
+		++liveTriangles[indices[i]];
+	}
+	vector<int> adjacencyStart(vertexCount + 1, 0);
+	for (int v = 0; v < vertexCount; ++v) {
+		adjacencyStart[v + 1] = adjacencyStart[v] + liveTriangles[v];
+	}
+	vector<int> adjacency(triangles * 3);
+	vector<int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+	for (int i = 0; i < triangles * 3; ++i) {
+		adjacency[fill[indices[i]]++] = i / 3;
+	}
+
+	vector<int> cacheTime(vertexCount, 0);
+	vector<unsigned char> emitted(triangles, 0);
+	vector<int> deadEnds, candidates;
+	vector<unsigned int> output;
+	output.reserve(triangles * 3);
+	int time = VERTEX_CACHE_SIZE + 1;
+	int cursor = 0;
+	int fanning = 0;
+	while (fanning >= 0) {
+		candidates.clear();
+		for (int a = adjacencyStart[fanning]; a < adjacencyStart[fanning + 1]; ++a) {
+			int t = adjacency[a];
+			if (emitted[t]) {
+				continue;
+			}
+			emitted[t] = 1;
+			for (int k = 0; k < 3; ++k) {
+				int v = indices[t * 3 + k];
+				output.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				--liveTriangles[v];
+				// a vertex not in the cache is transformed and enters it
+				if (time - cacheTime[v] > VERTEX_CACHE_SIZE) {
+					cacheTime[v] = time++;
+				}
+			}
+		}
+		fanning = nextVertex(cursor, vertexCount, candidates, cacheTime, time, liveTriangles, deadEnds);
+	}
+	copy(output.begin(), output.end(), indices);
+}
+
+void optimizeVertexFetch(vector<Vertex> &vertices, vector<unsigned int> &indices) {
+	vector<int> remap(vertices.size(), -1);
+	vector<Vertex> ordered;
+	ordered.reserve(vertices.size());
+	for (unsigned int i = 0; i < indices.size(); ++i) {
+		unsigned int v = indices[i];
+		if (remap[v] < 0) {
+			remap[v] = (int)ordered.size();
+			ordered.push_back(vertices[v]);
+		}
+		indices[i] = (unsigned int)remap[v];
+	}
+	vertices.swap(ordered);
+}
+
+float averageCacheMissRatio(const unsigned int *indices, int count, int vertexCount, int cacheSize) {
+	if (count < 3) {
+		return 0.0f;
+	}
+	// the time each vertex entered the FIFO, it is still in it while fewer than cacheSize have entered since
+	vector<int> entered(vertexCount, -cacheSize - 1);
+	int time = 0, misses = 0;
+	for (int i = 0; i < count; ++i) {
+		if (time - entered[indices[i]] > cacheSize) {
+			entered[indices[i]] = time++;
+			++misses;
+		}
+	}
+	return (float)misses / (count / 3);
+}
+
+MeshOptimizerStats optimizeMesh(vector<Vertex> &vertices, vector<unsigned int> &indices, const vector<unsigned int> &rangeStarts) {
+	MeshOptimizerStats stats;
+	stats.verticesBefore = (int)vertices.size();
+	stats.indexCount = (int)indices.size();
+	stats.missesBefore = indices.empty() ? 0.0f : averageCacheMissRatio(&indices[0], (int)indices.size(), (int)vertices.size());
+	weldVertices(vertices, indices);
+
+	// each range is reordered over the vertices it uses alone, numbered from 0, so the scratch stays its size
+	vector<int> local(vertices.size(), -1);
+	vector<unsigned int> used, rangeIndices;
+	for (unsigned int r = 0; r <= rangeStarts.size(); ++r) {
+		unsigned int first = (r == 0) ? 0 : rangeStarts[r - 1];
+		unsigned int end = (r < rangeStarts.size()) ? rangeStarts[r] : (unsigned int)indices.size();
+		if (end <= first) {
+			continue;
+		}
+		used.clear();
+		rangeIndices.resize(end - first);
+		for (unsigned int i = first; i < end; ++i) {
+			if (local[indices[i]] < 0) {
+				local[indices[i]] = (int)used.size();
+				used.push_back(indices[i]);
+			}
+			rangeIndices[i - first] = (unsigned int)local[indices[i]];
+		}
+		optimizeVertexCache(&rangeIndices[0], (int)rangeIndices.size(), (int)used.size());
+		for (unsigned int i = first; i < end; ++i) {
+			indices[i] = used[rangeIndices[i - first]];
+		}
+		for (unsigned int i = 0; i < used.size(); ++i) {
+			local[used[i]] = -1;
+		}
+	}
+
+	optimizeVertexFetch(vertices, indices);
+	stats.verticesAfter = (int)vertices.size();
+	stats.missesAfter = indices.empty() ? 0.0f : averageCacheMissRatio(&indices[0], (int)indices.size(), (int)vertices.size());
+	stats.shortIndices = vertices.size() <= 65536;
+	return stats;
+}
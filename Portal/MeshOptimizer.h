@@ -0,0 +1,35 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <vector>
+
+#include "Mesh.h"
+
+using namespace std;
+
+// entries of the FIFO post-transform cache the triangle order is optimised and measured for
+const int VERTEX_CACHE_SIZE = 16;
+
+// what optimizeMesh did to a mesh
+struct MeshOptimizerStats {
+	int verticesBefore, verticesAfter;
+	int indexCount;
+	float missesBefore, missesAfter;	// vertex shader runs per triangle, the average cache miss ratio
+	bool shortIndices;					// the mesh fits 16-bit indices
+};
+
+// merges bit-identical vertices and drops the unreferenced ones, returns the vertices left
+int weldVertices(vector<Vertex> &vertices, vector<unsigned int> &indices);
+// reorders the triangles of count indices for the post-transform cache with Tipsify
+// (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+void optimizeVertexCache(unsigned int *indices, int count, int vertexCount);
+// stores the vertices in the order the indices first use them, so vertex fetches stream through memory
+void optimizeVertexFetch(vector<Vertex> &vertices, vector<unsigned int> &indices);
+// vertex shader runs per triangle of count indices drawn through a FIFO cache of cacheSize entries
+float averageCacheMissRatio(const unsigned int *indices, int count, int vertexCount, int cacheSize = VERTEX_CACHE_SIZE);
+
+// welds, reorders the triangles and then the vertices; rangeStarts holds the first index of each range of
+// triangles that is drawn on its own, triangles are only reordered inside their range, which keeps its place
+MeshOptimizerStats optimizeMesh(vector<Vertex> &vertices, vector<unsigned int> &indices, const vector<unsigned int> &rangeStarts);
+
+#endif
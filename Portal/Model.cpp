@@ -36,29 +36,204 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
 	return textureID;
 }
 
-Model::Model(string const &path, bool gamma) : gammaCorrection(gamma) {
-	//loadModel(path);
-	loadMap(path);
+// resamples an RGBA image to the given size with bilinear filtering, so that all layers of a texture array share one size
+static void resampleImage(const unsigned char *src, int srcWidth, int srcHeight, unsigned char *dst, int dstWidth, int dstHeight) {
+	for (int y = 0; y < dstHeight; ++y) {
+		float fy = (y + 0.5f) * srcHeight / dstHeight - 0.5f;
+		int y0 = fy < 0.0f ? 0 : (int)fy;
+		int y1 = y0 + 1 < srcHeight ? y0 + 1 : srcHeight - 1;
+		float ty = fy - y0 < 0.0f ? 0.0f : fy - y0;
+		for (int x = 0; x < dstWidth; ++x) {
+			float fx = (x + 0.5f) * srcWidth / dstWidth - 0.5f;
+			int x0 = fx < 0.0f ? 0 : (int)fx;
+			int x1 = x0 + 1 < srcWidth ? x0 + 1 : srcWidth - 1;
+			float tx = fx - x0 < 0.0f ? 0.0f : fx - x0;
+			for (int c = 0; c < 4; ++c) {
+				float a = src[(y0 * srcWidth + x0) * 4 + c] * (1.0f - tx) + src[(y0 * srcWidth + x1) * 4 + c] * tx;
+				float b = src[(y1 * srcWidth + x0) * 4 + c] * (1.0f - tx) + src[(y1 * srcWidth + x1) * 4 + c] * tx;
+				dst[(y * dstWidth + x) * 4 + c] = (unsigned char)(a * (1.0f - ty) + b * ty + 0.5f);
+			}
+		}
+	}
+}
+
+unsigned int TextureArrayFromFiles(const string *paths, int count, const string &directory, int *widths, int *heights) {
+	TextureArrayImage image;
+	decodeTextureArray(paths, count, directory, widths, heights, image);
+	return uploadTextureArray(image);
+}
+
+void decodeTextureArray(const string *paths, int count, const string &directory, int *widths, int *heights, TextureArrayImage &image) {
+	vector<unsigned char *> images(count);
+	int arrayWidth = 1, arrayHeight = 1;
+	for (int i = 0; i < count; ++i) {
+		string filename = directory + '/' + paths[i];
+		int nrComponents;
+		images[i] = stbi_load(filename.c_str(), &widths[i], &heights[i], &nrComponents, 4);
+		if (!images[i]) {
+			std::cout << "Texture failed to load at path: " << paths[i] << std::endl;
+			widths[i] = heights[i] = 1;
+			continue;
+		}
+		arrayWidth = max(arrayWidth, widths[i]);
+		arrayHeight = max(arrayHeight, heights[i]);
+	}
+
+	image.width = arrayWidth;
+	image.height = arrayHeight;
+	image.layers = count;
+	size_t layerSize = (size_t)arrayWidth * arrayHeight * 4;
+	image.pixels.resize(layerSize * count);
+	for (int i = 0; i < count; ++i) {
+		unsigned char *layer = &image.pixels[layerSize * i];
+		if (!images[i]) {
+			fill(layer, layer + layerSize, 255);
+		}
+		else if (widths[i] == arrayWidth && heights[i] == arrayHeight) {
+			copy(images[i], images[i] + layerSize, layer);
+		}
+		else {
+			resampleImage(images[i], widths[i], heights[i], layer, arrayWidth, arrayHeight);
+		}
+		stbi_image_free(images[i]);
+	}
+}
+
+unsigned int uploadTextureArray(const TextureArrayImage &image) {
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, image.width, image.height, image.layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.empty() ? NULL : &image.pixels[0]);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	return textureID;
+}
+
+Model::Model(string const &path, bool gamma, bool deferUpload) : visibleChunks(0), gammaCorrection(gamma), deferUpload(deferUpload), uploaded(!deferUpload) {
+	optimization.verticesBefore = optimization.verticesAfter = optimization.indexCount = 0;
+	optimization.missesBefore = optimization.missesAfter = 0.0f;
+	optimization.shortIndices = true;
+	// maps are text files, anything else is loaded with Assimp
+	if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".txt") == 0)
+		loadMap(path);
+	else
+		loadModel(path);
+	reportOptimization(path);
+}
+
+void Model::upload() {
+	if (uploaded) {
+		return;
+	}
+	if (!pendingTextures.pixels.empty()) {
+		unsigned int id = uploadTextureArray(pendingTextures);
+		for (unsigned int i = 0; i < meshes.size(); i++) {
+			for (unsigned int j = 0; j < meshes[i].textures.size(); j++) {
+				if (meshes[i].textures[j].type == TEXTURE_ARRAY) {
+					meshes[i].textures[j].id = id;
+				}
+			}
+		}
+		TextureArrayImage().pixels.swap(pendingTextures.pixels);
+	}
+	for (unsigned int i = 0; i < meshes.size(); i++)
+		meshes[i].setupMesh();
+	uploaded = true;
+}
+
+void Model::release() {
+	// textures shared by meshes are deleted once
+	vector<unsigned int> textureIds;
+	for (unsigned int i = 0; i < meshes.size(); i++) {
+		for (unsigned int j = 0; j < meshes[i].textures.size(); j++) {
+			textureIds.push_back(meshes[i].textures[j].id);
+		}
+		meshes[i].release();
+	}
+	for (unsigned int i = 0; i < materials.size(); i++) {
+		for (unsigned int j = 0; j < materials[i].textures.size(); j++) {
+			textureIds.push_back(materials[i].textures[j].id);
+		}
+	}
+	sort(textureIds.begin(), textureIds.end());
+	textureIds.erase(unique(textureIds.begin(), textureIds.end()), textureIds.end());
+	if (!textureIds.empty()) {
+		glDeleteTextures((GLsizei)textureIds.size(), &textureIds[0]);
+	}
+	uploaded = false;
+}
+
+const Material *Model::materialOf(const Mesh &mesh) const {
+	return (mesh.material >= 0) ? &materials[mesh.material] : NULL;
 }
 
 // draws the model, and thus all its meshes
 void Model::Draw(Shader shader) {
 	for (unsigned int i = 0; i < meshes.size(); i++)
-		meshes[i].Draw(shader);
+		meshes[i].Draw(shader, materialOf(meshes[i]));
 }
 
 void Model::DrawExcept(Shader shader, glm::vec3 pos, glm::vec3 n) {
-	for (unsigned int i = 0; i < singleMeshes.size(); i++) {
-		Vertex v = singleMeshes[i].vertices[0];
-		if (abs(v.Normal.x) == abs(n.x) && abs(v.Normal.y) == abs(n.y) && (
-			(n.x == 1.0f && v.Position.x < pos.x + 1.0f) || 
-			(n.x == -1.0f && v.Position.x > pos.x - 1.0f) ||
-			(n.y == 1.0f && v.Position.y < pos.y + 1.0f) || 
-			(n.y == -1.0f && v.Position.y > pos.y - 1.0f))) {
+	// everything behind the plane, including the wall the portal sits on, is removed by the clip distance
+	shader.setVec4("clipPlane", glm::vec4(n, -glm::dot(n, pos)));
+	for (unsigned int i = 0; i < meshes.size(); i++)
+		meshes[i].Draw(shader, materialOf(meshes[i]));
+}
+
+void Model::DrawInstanced(Shader shader, int instances) {
+	for (unsigned int i = 0; i < meshes.size(); i++)
+		meshes[i].DrawInstanced(shader, instances, materialOf(meshes[i]));
+}
+
+void Model::DrawChunks(Shader shader, glm::vec3 eye, const Frustum *frustum, const unsigned char *potentiallyVisible, bool sortFrontToBack, FrameArena &arena) {
+	if (chunks.empty()) {
+		Draw(shader);
+		return;
+	}
+	unsigned char *chunkVisible = arena.allocate<unsigned char>(chunks.size());
+	if (frustum != NULL) {
+		visibleChunks = frustum->cullBoxes(chunkBounds, chunkVisible);
+	}
+	else {
+		fill(chunkVisible, chunkVisible + chunks.size(), 1);
+		visibleChunks = chunks.size();
+	}
+	if (potentiallyVisible != NULL) {
+		visibleChunks = 0;
+		for (unsigned int i = 0; i < chunks.size(); i++) {
+			chunkVisible[i] = chunkVisible[i] && potentiallyVisible[i];
+			visibleChunks += chunkVisible[i];
+		}
+	}
+	if (visibleChunks == 0) {
+		return;
+	}
+	pair<float, int> *chunkOrder = arena.allocate<pair<float, int>>(visibleChunks);
+	int orderCount = 0;
+	for (unsigned int i = 0; i < chunks.size(); i++) {
+		if (!chunkVisible[i]) {
 			continue;
 		}
-		singleMeshes[i].Draw(shader);
+		// squared distance from the eye to the closest point of the chunk
+		glm::vec3 d = glm::max(chunks[i].boundsMin - eye, glm::max(eye - chunks[i].boundsMax, glm::vec3(0.0f)));
+		chunkOrder[orderCount++] = make_pair(sortFrontToBack ? glm::dot(d, d) : 0.0f, (int)i);
+	}
+	if (sortFrontToBack) {
+		sort(chunkOrder, chunkOrder + orderCount);
+	}
+	GLsizei *chunkCounts = arena.allocate<GLsizei>(orderCount);
+	const void **chunkOffsets = arena.allocate<const void *>(orderCount);
+	for (int i = 0; i < orderCount; i++) {
+		const MapChunk &chunk = chunks[chunkOrder[i].second];
+		chunkCounts[i] = chunk.indexCount;
+		chunkOffsets[i] = (const void *)(size_t)(chunk.firstIndex * meshes[0].indexSize());
 	}
+	meshes[0].DrawRanges(shader, chunkCounts, chunkOffsets, orderCount, materialOf(meshes[0]));
 }
 
 void Model::loadModel(string const &path) {
@@ -73,6 +248,7 @@ void Model::loadModel(string const &path) {
 	}
 	// retrieve the directory path of the filepath
 	directory = path.substr(0, path.find_last_of('/'));
+	sceneMaterials.assign(scene->mNumMaterials, -1);
 
 	// process ASSIMP's root node recursively
 	processNode(scene->mRootNode, scene);
@@ -97,11 +273,11 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
 	// data to fill
 	vector<Vertex> vertices;
 	vector<unsigned int> indices;
-	vector<Texture> textures;
 
 	// Walk through each of the mesh's vertices
 	for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-		Vertex vertex;
+		// zeroed, the vertices are welded by their bytes
+		Vertex vertex = Vertex();
 		glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
 						  // positions
 		vector.x = mesh->mVertices[i].x;
@@ -145,60 +321,60 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
 		for (unsigned int j = 0; j < face.mNumIndices; j++)
 			indices.push_back(face.mIndices[j]);
 	}
-	// process materials
-	aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+	// Assimp emits three vertices per triangle in file order
+	optimize(vertices, indices, vector<unsigned int>());
+
+	// the material is shared with the other meshes using it
+	int material = loadMaterial(scene, mesh->mMaterialIndex);
+
+	// return a mesh object created from the extracted mesh data
+	return Mesh(vertices, indices, vector<Texture>(), material);
+}
+
+int Model::loadMaterial(const aiScene *scene, unsigned int index) {
+	if (sceneMaterials[index] >= 0) {
+		return sceneMaterials[index];
+	}
+	aiMaterial* material = scene->mMaterials[index];
 	// we assume a convention for sampler names in the shaders. Each diffuse texture should be named
 	// as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER. 
 	// Same applies to other texture as the following list summarizes:
 	// diffuse: texture_diffuseN
 	// specular: texture_specularN
 	// normal: texture_normalN
-
+	Material loaded;
 	// 1. diffuse maps
-	vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-	textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+	loadMaterialTextures(material, aiTextureType_DIFFUSE, TEXTURE_DIFFUSE, loaded.textures);
 	// 2. specular maps
-	vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-	textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+	loadMaterialTextures(material, aiTextureType_SPECULAR, TEXTURE_SPECULAR, loaded.textures);
 	// 3. normal maps
-	std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-	textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+	loadMaterialTextures(material, aiTextureType_HEIGHT, TEXTURE_NORMAL, loaded.textures);
 	// 4. height maps
-	std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-	textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-
-	// return a mesh object created from the extracted mesh data
-	return Mesh(vertices, indices, textures);
+	loadMaterialTextures(material, aiTextureType_AMBIENT, TEXTURE_HEIGHT, loaded.textures);
+	materials.push_back(loaded);
+	sceneMaterials[index] = (int)materials.size() - 1;
+	return sceneMaterials[index];
 }
 
 // checks all material textures of a given type and loads the textures if they're not loaded yet.
-// the required info is returned as a Texture struct.
-vector<Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName) {
-	vector<Texture> textures;
+void Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type, TextureType textureType, vector<Texture> &textures) {
 	for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
 	{
 		aiString str;
 		mat->GetTexture(type, i, &str);
-		// check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-		bool skip = false;
-		for (unsigned int j = 0; j < textures_loaded.size(); j++) {
-			if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-			{
-				textures.push_back(textures_loaded[j]);
-				skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-				break;
-			}
+		Texture texture;
+		texture.type = textureType;
+		// a texture with the same filepath has already been loaded, it is shared
+		unordered_map<string, unsigned int>::const_iterator loaded = textures_loaded.find(str.C_Str());
+		if (loaded != textures_loaded.end()) {
+			texture.id = loaded->second;
 		}
-		if (!skip) {   // if texture hasn't been loaded already, load it
-			Texture texture;
+		else {
 			texture.id = TextureFromFile(str.C_Str(), this->directory);
-			texture.type = typeName;
-			texture.path = str.C_Str();
-			textures.push_back(texture);
-			textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
+			textures_loaded[str.C_Str()] = texture.id;
 		}
+		textures.push_back(texture);
 	}
-	return textures;
 }
 
 void Model::loadMap(string const &path) {
@@ -207,13 +383,20 @@ void Model::loadMap(string const &path) {
 		std::cout << "Map failed to load at path: " << path << std::endl;
 		return;
 	}
-	int id[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-	vector<Vertex> vertices[7];
-	vector<unsigned int> indices[7];
-	vector<Texture> textures[7];
-	float textureWidth[7] = { 650, 357, 640, 447, 429, 980, 640 };
-	float textureHeight[7] = { 613, 357, 480, 783, 729, 653, 490 };
+	vector<Vertex> vertices;
+	vector<unsigned int> indices;
+	vector<Texture> textures;
+	int textureWidth[7], textureHeight[7];
 	string textureNames[7] = { "wall_v_1.png", "wall_v_2.png", "wall_w_2.jpg", "blue_portal.png", "orange_portal.png", "ceil_2.jpg", "pillar_1.png" };
+	Texture tmpTexture;
+	// decoded now, the texture is created by upload() when that is deferred
+	decodeTextureArray(textureNames, 7, "Textures/", textureWidth, textureHeight, pendingTextures);
+	tmpTexture.id = deferUpload ? 0 : uploadTextureArray(pendingTextures);
+	tmpTexture.type = TEXTURE_ARRAY;
+	if (!deferUpload) {
+		TextureArrayImage().pixels.swap(pendingTextures.pixels);
+	}
+	textures.push_back(tmpTexture);
 	while (true) {
 		if (inFile.eof()) {
 			break;
@@ -221,9 +404,6 @@ void Model::loadMap(string const &path) {
 		char type;
 		inFile >> type;
 		if (type == 'R') {
-			vector<Vertex> vertices_;
-			vector<unsigned int> indices_;
-			vector<Texture> textures_;
 			double p[4][3], n[3];
 			if (inFile.eof()) {
 				break;
@@ -242,13 +422,19 @@ void Model::loadMap(string const &path) {
 			inFile >> tCh;
 			int textureId = 0;
 			inFile >> textureId;
+			if (textureId < 1 || textureId > 7) {
+				std::cout << "Map texture id out of range: " << textureId << std::endl;
+				continue;
+			}
 			int order[] = { 0, 1, 2, 0, 2, 3 };
+			float texCorWidth = 300.0f * sqrt(pow(p[1][0] - p[0][0], 2) + pow(p[1][1] - p[0][1], 2) + pow(p[1][2] - p[0][2], 2));
+			float texCorHeight = 300.0f * sqrt(pow(p[1][0] - p[2][0], 2) + pow(p[1][1] - p[2][1], 2) + pow(p[1][2] - p[2][2], 2));
+			float texX = texCorWidth / textureWidth[textureId - 1];
+			float texY = texCorHeight / textureHeight[textureId - 1];
+			unsigned int first = vertices.size();
 			for (int i = 0; i < 4; ++i) {
-				Vertex v;
-				float texCorWidth = 300.0f * (textureId == 1 ? 1.0f : 1.0f) * sqrt(pow(p[1][0] - p[0][0], 2) + pow(p[1][1] - p[0][1], 2) + pow(p[1][2] - p[0][2], 2));
-				float texCorHeight = 300.0f * (textureId == 1 ? 1.0f : 1.0f) * sqrt(pow(p[1][0] - p[2][0], 2) + pow(p[1][1] - p[2][1], 2) + pow(p[1][2] - p[2][2], 2));
-				float texX = texCorWidth / textureWidth[textureId - 1];
-				float texY = texCorHeight / textureHeight[textureId - 1];
+				// zeroed, the vertices are welded by their bytes
+				Vertex v = Vertex();
 				switch (i) {
 				case 0:
 					v.TexCoords = glm::vec2(0.0f, 0.0f);
@@ -265,6 +451,7 @@ void Model::loadMap(string const &path) {
 				default:
 					break;
 				}
+				v.TexLayer = (float)(textureId - 1);
 				glm::vec3 vector;
 				vector.x = p[i][0];
 				vector.y = p[i][1];
@@ -274,36 +461,73 @@ void Model::loadMap(string const &path) {
 				vector.y = n[1];
 				vector.z = n[2];
 				v.Normal = vector;
-				vertices[textureId - 1].push_back(v);
-				vertices_.push_back(v);
+				vertices.push_back(v);
 			}
 			for (int i = 0; i < 6; ++i) {
-				indices[textureId - 1].push_back(id[textureId - 1] + order[i]);
-				indices_.push_back(order[i]);
+				indices.push_back(first + order[i]);
 			}
-			Texture tmpTexture;
-			tmpTexture.id = TextureFromFile(textureNames[textureId - 1].c_str(), "Textures/");
-			tmpTexture.path = textureNames[textureId - 1].c_str();
-			tmpTexture.type = "texture_diffuse";
-			textures_.push_back(tmpTexture);
-			Mesh m(vertices_, indices_, textures_);
-			singleMeshes.push_back(m);
-			id[textureId - 1] += 4;
 		}
 		else {
 			break;
 		}
 	}
-	Texture tmpTexture;
-	for (int i = 0; i < 7; ++i) {
-		tmpTexture.id = TextureFromFile(textureNames[i].c_str(), "Textures/");
-		tmpTexture.path = textureNames[i].c_str();
-		tmpTexture.type = "texture_diffuse";
-		textures[i].push_back(tmpTexture);
-	}
 	inFile.close();
-	for (int i = 0; i < 7; ++i) {
-		Mesh mesh(vertices[i], indices[i], textures[i]);
-		meshes.push_back(mesh);
+	if (vertices.empty()) {
+		return;
+	}
+
+	// group the quads by the grid cell of their center, then lay out the indices chunk by chunk
+	map<pair<int, int>, vector<unsigned int>> cells;
+	for (unsigned int q = 0; q < vertices.size() / 4; ++q) {
+		glm::vec3 center = (vertices[q * 4].Position + vertices[q * 4 + 2].Position) * 0.5f;
+		cells[make_pair((int)floor(center.x / MAP_CHUNK_SIZE), (int)floor(center.y / MAP_CHUNK_SIZE))].push_back(q);
+	}
+	vector<unsigned int> chunkIndices;
+	for (map<pair<int, int>, vector<unsigned int>>::iterator it = cells.begin(); it != cells.end(); ++it) {
+		MapChunk chunk;
+		chunk.firstIndex = chunkIndices.size();
+		chunk.boundsMin = glm::vec3(FLT_MAX);
+		chunk.boundsMax = glm::vec3(-FLT_MAX);
+		for (unsigned int i = 0; i < it->second.size(); ++i) {
+			unsigned int q = it->second[i];
+			for (int j = 0; j < 4; ++j) {
+				chunk.boundsMin = glm::min(chunk.boundsMin, vertices[q * 4 + j].Position);
+				chunk.boundsMax = glm::max(chunk.boundsMax, vertices[q * 4 + j].Position);
+			}
+			chunkIndices.insert(chunkIndices.end(), indices.begin() + q * 6, indices.begin() + q * 6 + 6);
+		}
+		chunk.indexCount = chunkIndices.size() - chunk.firstIndex;
+		chunks.push_back(chunk);
+		chunkBounds.add(chunk.boundsMin, chunk.boundsMax);
+	}
+	// the PVS reads the quads from the indices, before optimize() reorders their triangles
+	pvs.build(vertices, chunkIndices, chunks, MAP_CHUNK_SIZE);
+	// triangles stay in their chunk, so chunks keep drawing as one index range each
+	vector<unsigned int> chunkStarts;
+	for (unsigned int i = 1; i < chunks.size(); ++i) {
+		chunkStarts.push_back(chunks[i].firstIndex);
+	}
+	optimize(vertices, chunkIndices, chunkStarts);
+	meshes.push_back(Mesh(vertices, chunkIndices, textures, -1, deferUpload));
+}
+
+void Model::optimize(vector<Vertex> &vertices, vector<unsigned int> &indices, const vector<unsigned int> &rangeStarts) {
+	MeshOptimizerStats stats = optimizeMesh(vertices, indices, rangeStarts);
+	float triangles = stats.indexCount / 3.0f;
+	optimization.verticesBefore += stats.verticesBefore;
+	optimization.verticesAfter += stats.verticesAfter;
+	optimization.indexCount += stats.indexCount;
+	optimization.missesBefore += stats.missesBefore * triangles;
+	optimization.missesAfter += stats.missesAfter * triangles;
+	optimization.shortIndices = optimization.shortIndices && stats.shortIndices;
+}
+
+void Model::reportOptimization(string const &path) const {
+	if (optimization.indexCount == 0) {
+		return;
 	}
+	float triangles = optimization.indexCount / 3.0f;
+	std::cout << path << ": " << optimization.verticesBefore << " -> " << optimization.verticesAfter << " vertices, "
+		<< optimization.indexCount << (optimization.shortIndices ? " 16-bit" : " 32-bit") << " indices, "
+		<< optimization.missesBefore / triangles << " -> " << optimization.missesAfter / triangles << " vertex shader runs per triangle" << std::endl;
 }
@@ -12,34 +12,81 @@
 
 #include "Mesh.h"
 #include "Shader.h"
+#include "Frustum.h"
+#include "Visibility.h"
+#include "FrameArena.h"
+#include "MeshOptimizer.h"
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <cfloat>
 #include <vector>
 
 using namespace std;
 
 extern unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
+extern unsigned int TextureArrayFromFiles(const string *paths, int count, const string &directory, int *widths, int *heights);
+
+// the layers of a texture array decoded and brought to one size, ready to be uploaded
+struct TextureArrayImage {
+	int width, height, layers;
+	vector<unsigned char> pixels;	// layer after layer of RGBA rows
+};
+// the file reading half of TextureArrayFromFiles, needs no GL context
+void decodeTextureArray(const string *paths, int count, const string &directory, int *widths, int *heights, TextureArrayImage &image);
+unsigned int uploadTextureArray(const TextureArrayImage &image);
+
+// edge length of the grid cells the map is split into
+const float MAP_CHUNK_SIZE = 8.0f;
+
+// a spatial piece of the batched map mesh, its triangles are a contiguous range of the index buffer
+struct MapChunk {
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+	unsigned int firstIndex;
+	unsigned int indexCount;
+};
 
 class Model {
 public:
 	/*  Model Data */
-	vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+	unordered_map<string, unsigned int> textures_loaded;	// the texture of every path loaded so far, so each file is loaded once
+	vector<Material> materials;	// the materials used by the meshes, loaded once each however many meshes share them
 	vector<Mesh> meshes;
-	vector<Mesh> singleMeshes;
+	vector<MapChunk> chunks;	// chunks of meshes[0] when loaded from a map
+	BoundsSoA chunkBounds;		// bounds of the chunks laid out for culling
+	int visibleChunks;			// chunks submitted by the last DrawChunks
+	PVS pvs;					// chunks potentially visible from each grid cell
 	string directory;
 	bool gammaCorrection;
 
 	/*  Functions   */
-	// constructor, expects a filepath to a 3D model.
-	Model(string const &path, bool gamma = false);
+	// constructor, expects a filepath to a 3D model. A map loaded with deferUpload touches no GL and can be
+	// loaded on any thread, its GL objects are created by upload() on the thread owning the context
+	Model(string const &path, bool gamma = false, bool deferUpload = false);
+
+	// creates the buffers and textures of a model loaded with deferUpload
+	void upload();
+	// deletes the buffers and textures of the model, the CPU side data stays
+	void release();
+
+	// the material of a mesh of the model, NULL if it has its own textures
+	const Material *materialOf(const Mesh &mesh) const;
 
 	// draws the model, and thus all its meshes
 	void Draw(Shader shader);
+	// draws the model clipped to the half space in front of the plane (pos, n), expects GL_CLIP_DISTANCE0 to be enabled
 	void DrawExcept(Shader shader, glm::vec3 pos, glm::vec3 n);
+	// draws the model once per view of a MultiView
+	void DrawInstanced(Shader shader, int instances);
+	// draws the map chunks inside frustum (all chunks if NULL) and marked in potentiallyVisible (all chunks if NULL)
+	// in a single multi-draw, optionally ordered front to back from eye; the draw lists are built in arena
+	void DrawChunks(Shader shader, glm::vec3 eye, const Frustum *frustum, const unsigned char *potentiallyVisible, bool sortFrontToBack, FrameArena &arena);
 
 private:
 	/*  Functions   */
@@ -51,11 +98,21 @@ private:
 
 	Mesh processMesh(aiMesh *mesh, const aiScene *scene);
 
-	// checks all material textures of a given type and loads the textures if they're not loaded yet.
-	// the required info is returned as a Texture struct.
-	vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName);
+	// returns the index in materials of material index of the scene, loading it when first used
+	int loadMaterial(const aiScene *scene, unsigned int index);
+
+	// adds all material textures of a given type to textures and loads the textures if they're not loaded yet.
+	void loadMaterialTextures(aiMaterial *mat, aiTextureType type, TextureType textureType, vector<Texture> &textures);
+
+	bool deferUpload, uploaded;
+	TextureArrayImage pendingTextures;	// of a map until upload()
+	vector<int> sceneMaterials;	// index in materials of each material of the scene loading, -1 until used
+	MeshOptimizerStats optimization;	// totals over the meshes loaded, the cache miss ratios weighted by triangles
+	// optimizes a mesh on import and adds it to the totals, reported by reportOptimization()
+	void optimize(vector<Vertex> &vertices, vector<unsigned int> &indices, const vector<unsigned int> &rangeStarts);
+	void reportOptimization(string const &path) const;
 
-	// load Mesh from Map
+	// load Mesh from Map, all quads are batched into a single mesh sampling one texture array
 	void loadMap(string const &path);
 };
 
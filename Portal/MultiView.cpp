@@ -0,0 +1,48 @@
+#include "MultiView.h"
+
+MultiView::MultiView() : UBO(0), viewCount(0) {
+	//
+}
+
+MultiView::~MultiView() {
+	//
+}
+
+void MultiView::initialize() {
+	glGenBuffers(1, &UBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(ViewBlock), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void MultiView::clear() {
+	viewCount = 0;
+}
+
+int MultiView::addView(glm::mat4 viewProjection, const glm::vec4 *planes, int planeCount) {
+	if (viewCount >= MAX_VIEWS) {
+		return -1;
+	}
+	block.viewProjection[viewCount] = viewProjection;
+	for (int i = 0; i < VIEW_CLIP_PLANES; ++i) {
+		// a plane of (0, 0, 0, 1) keeps every vertex
+		block.clipPlanes[viewCount * VIEW_CLIP_PLANES + i] = (planes != NULL && i < planeCount) ? planes[i] : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	return viewCount++;
+}
+
+void MultiView::transformViews(const glm::mat4 &transform) {
+	for (int i = 0; i < viewCount; ++i) {
+		block.viewProjection[i] = transform * block.viewProjection[i];
+	}
+}
+
+void MultiView::upload(Shader shader) const {
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ViewBlock), &block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	unsigned int blockIndex = glGetUniformBlockIndex(shader.ID, "Views");
+	glUniformBlockBinding(shader.ID, blockIndex, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, 0, UBO);
+}
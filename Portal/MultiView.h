@@ -0,0 +1,44 @@
+#ifndef MULTIVIEW_H
+#define MULTIVIEW_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Shader.h"
+
+// must match MAX_VIEWS and VIEW_CLIP_PLANES in shader_multiview.vs
+#define MAX_VIEWS 8
+#define VIEW_CLIP_PLANES 5
+
+// Uniform buffer holding the view-projection matrix and clip planes of every view rendered in a frame.
+// Instanced draws pick their view with viewBase + gl_InstanceID, so the scene is submitted once for all portal views.
+class MultiView {
+public:
+	unsigned int UBO;
+	int viewCount;
+
+public:
+	MultiView();
+	~MultiView();
+
+	void initialize();
+	// removes all views, call once per frame before adding views
+	void clear();
+	// adds a view and returns its index, planes may be NULL for a view without clipping
+	int addView(glm::mat4 viewProjection, const glm::vec4 *planes, int planeCount);
+	// multiplies the view-projection of every view by transform from the left
+	void transformViews(const glm::mat4 &transform);
+	// uploads the views and binds the buffer to the Views block of the shader
+	void upload(Shader shader) const;
+
+private:
+	struct ViewBlock {
+		glm::mat4 viewProjection[MAX_VIEWS];
+		glm::vec4 clipPlanes[MAX_VIEWS * VIEW_CLIP_PLANES];
+	};
+	ViewBlock block;
+};
+
+#endif
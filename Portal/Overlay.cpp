@@ -0,0 +1,128 @@
+#include "Overlay.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+
+// 3x5 pixel font, the rows of each glyph from the top, a character per pixel
+static const char fontCharacters[] = " 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ.:/-%";
+static const char *fontGlyphs[] = {
+	"000000000000000",
+	"111101101101111", "010110010010111", "111001111100111", "111001111001111", "101101111001001",
+	"111100111001111", "111100111101111", "111001001001001", "111101111101111", "111101111001111",
+	"010101111101101", "110101110101110", "011100100100011", "110101101101110", "111100110100111",
+	"111100110100100", "011100101101011", "101101111101101", "111010010010111", "001001001101010",
+	"101101110101101", "100100100100111", "101111111101101", "110101101101101", "010101101101010",
+	"110101110100100", "010101101110011", "110101110101101", "011100010001110", "111010010010010",
+	"101101101101111", "101101101101010", "101101111111101", "101101010101101", "101101010010010",
+	"111001010100111",
+	"000000000000010", "000010000010000", "001001010100100", "000000111000000", "101001010100101"
+};
+
+void OverlayBatch::clear() {
+	vertices.clear();
+}
+
+void OverlayBatch::rect(float x, float y, float width, float height, glm::vec4 color) {
+	quad(x, y, width, height, glm::vec2(-1.0f), glm::vec2(-1.0f), color);
+}
+
+void OverlayBatch::image(float x, float y, float width, float height) {
+	quad(x, y, width, height, glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec4(1.0f));
+}
+
+float OverlayBatch::text(float x, float y, float pixel, const char *text, glm::vec4 color) {
+	float start = x;
+	for (const char *c = text; *c != '\0'; ++c) {
+		char upper = (*c >= 'a' && *c <= 'z') ? (char)(*c - 'a' + 'A') : *c;
+		const char *found = strchr(fontCharacters, upper);
+		// characters the font lacks show as spaces
+		const char *glyph = (found != NULL && upper != '\0') ? fontGlyphs[found - fontCharacters] : fontGlyphs[0];
+		for (int row = 0; row < 5; ++row) {
+			for (int column = 0; column < 3; ++column) {
+				if (glyph[row * 3 + column] == '1') {
+					rect(x + column * pixel, y + row * pixel, pixel, pixel, color);
+				}
+			}
+		}
+		x += 4 * pixel;
+	}
+	return x - start;
+}
+
+void OverlayBatch::graph(float x, float y, float width, float height, const float *values, int count, int first, float maxValue, glm::vec4 color) {
+	if (count <= 0 || maxValue <= 0.0f) {
+		return;
+	}
+	float barWidth = width / count;
+	for (int i = 0; i < count; ++i) {
+		float barHeight = min(values[(first + i) % count] / maxValue, 1.0f) * height;
+		rect(x + i * barWidth, y + height - barHeight, barWidth, barHeight, color);
+	}
+}
+
+void OverlayBatch::quad(float x, float y, float width, float height, glm::vec2 uvMin, glm::vec2 uvMax, glm::vec4 color) {
+	OverlayVertex corners[4];
+	const glm::vec2 offsets[4] = { glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f) };
+	for (int i = 0; i < 4; ++i) {
+		corners[i].position = glm::vec2(x, y) + offsets[i] * glm::vec2(width, height);
+		corners[i].texCoord = uvMin + offsets[i] * (uvMax - uvMin);
+		for (int c = 0; c < 4; ++c) {
+			corners[i].color[c] = (unsigned char)(glm::clamp(color[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
+	}
+	// two triangles, the batch is drawn without indices
+	const int order[6] = { 0, 1, 2, 0, 2, 3 };
+	for (int i = 0; i < 6; ++i) {
+		vertices.push_back(corners[order[i]]);
+	}
+}
+
+OverlayRenderer::OverlayRenderer() : VAO(0), VBO(0), texture(0), capacity(0) {
+	//
+}
+
+OverlayRenderer::~OverlayRenderer() {
+	//
+}
+
+void OverlayRenderer::initialize(const char *imagePath) {
+	texture = TextureFromFile(imagePath, "Textures/", false);
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(OverlayVertex), (void*)offsetof(OverlayVertex, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(OverlayVertex), (void*)offsetof(OverlayVertex, texCoord));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(OverlayVertex), (void*)offsetof(OverlayVertex, color));
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void OverlayRenderer::Draw(Shader shader, const OverlayVertex *vertices, int count, int screenWidth, int screenHeight) {
+	if (count == 0) {
+		return;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	if (count > capacity) {
+		capacity = max(count, capacity * 2);
+		glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(OverlayVertex), NULL, GL_STREAM_DRAW);
+	}
+	else {
+		// orphaned, so the upload doesn't wait for the draws of the last frame
+		glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(OverlayVertex), NULL, GL_STREAM_DRAW);
+	}
+	glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(OverlayVertex), vertices);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	shader.setVec2("screenSize", (float)screenWidth, (float)screenHeight);
+	shader.setInt("overlayImage", 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glBindVertexArray(VAO);
+	glDrawArrays(GL_TRIANGLES, 0, count);
+	glBindVertexArray(0);
+}
@@ -0,0 +1,63 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+
+#include "Shader.h"
+
+using namespace std;
+
+extern unsigned int TextureFromFile(const char *path, const string &directory, bool gamma);
+
+// a corner of an overlay quad, in pixels from the top left corner of the screen
+struct OverlayVertex {
+	glm::vec2 position;
+	glm::vec2 texCoord;			// negative for plain colour, otherwise the overlay image is sampled
+	unsigned char color[4];
+};
+
+// The 2D overlay of a frame: crosshair, hints, debug text and graphs. The game thread adds quads in screen
+// pixels every frame, without touching GL, and the whole batch is drawn with one call on top of the frame.
+// The vertices keep their capacity across frames, so steady-state frames don't allocate.
+class OverlayBatch {
+public:
+	vector<OverlayVertex> vertices;
+
+public:
+	void clear();
+	void rect(float x, float y, float width, float height, glm::vec4 color);
+	// the overlay image stretched over the rectangle
+	void image(float x, float y, float width, float height);
+	// upper case letters, digits, spaces and . : / - %, pixel is the size of a font pixel; returns the width
+	float text(float x, float y, float pixel, const char *text, glm::vec4 color);
+	// a bar per value, scaled so maxValue fills the height; values are read from first on, wrapping after count
+	void graph(float x, float y, float width, float height, const float *values, int count, int first, float maxValue, glm::vec4 color);
+
+private:
+	void quad(float x, float y, float width, float height, glm::vec2 uvMin, glm::vec2 uvMax, glm::vec4 color);
+};
+
+// Draws overlay batches with shader_overlay, all quads in a single draw from one dynamic vertex buffer.
+class OverlayRenderer {
+public:
+	unsigned int VAO, VBO, texture;
+
+public:
+	OverlayRenderer();
+	~OverlayRenderer();
+
+	// loads the image the textured quads show, a file of the Textures directory
+	void initialize(const char *imagePath);
+	// uploads count vertices and draws them over the screen of the given size
+	void Draw(Shader shader, const OverlayVertex *vertices, int count, int screenWidth, int screenHeight);
+
+private:
+	int capacity;
+};
+
+#endif
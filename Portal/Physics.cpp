@@ -1,6 +1,13 @@
 #include "Physics.h"
 
-Physics::Physics(string const &path, string const &winPath, glm::vec3 up) {
+// a win point no player gets near
+const glm::vec3 NO_WIN_POINT(1e9f, 1e9f, 1e9f);
+
+Physics::Physics() : worldUp(0.0f, 0.0f, 1.0f), winPoint(NO_WIN_POINT) {
+	//
+}
+
+Physics::Physics(string const &path, string const &winPath, glm::vec3 up) : winPoint(NO_WIN_POINT) {
 	worldUp = up;
 	ifstream inFile(path);
 	if (!inFile) {
@@ -90,8 +97,8 @@ void Physics::updateVerticleState(glm::vec3 &v, glm::vec3 &pos, double deltaTime
 		if (!(pos.z >= zPlanes[i].second && pos_.z <= zPlanes[i].second)) {
 			continue;
 		}
-		vector<pair<double, double>> polygon = zPlanes[i].first;
-		if (!isInPolygon(make_pair(pos.x, pos.y), polygon)) {
+		const vector<pair<double, double>> &polygon = zPlanes[i].first;
+		if (!isInPolygon(make_pair(pos.x, pos.y), polygon) || isInOpening(2, zPlanes[i].second, pos)) {
 			continue;
 		}
 		isJumping = false;
@@ -114,8 +121,8 @@ bool Physics::isHorizontalAvailable(glm::vec3 &pos, glm::vec3 movement) {
 		if (!((pos.x <= xPlanes[i].second && pos_.x >= xPlanes[i].second) || (pos.x >= xPlanes[i].second && pos_.x <= xPlanes[i].second))) {
 			continue;
 		}
-		vector<pair<double, double>> polygon = xPlanes[i].first;
-		if (!isInPolygon(pos2, polygon)) {
+		const vector<pair<double, double>> &polygon = xPlanes[i].first;
+		if (!isInPolygon(pos2, polygon) || isInOpening(0, xPlanes[i].second, pos)) {
 			continue;
 		}
 		return false;
@@ -126,8 +133,8 @@ bool Physics::isHorizontalAvailable(glm::vec3 &pos, glm::vec3 movement) {
 		if (!((pos.y <= yPlanes[i].second && pos_.y >= yPlanes[i].second) || (pos.y >= yPlanes[i].second && pos_.y <= yPlanes[i].second))) {
 			continue;
 		}
-		vector<pair<double, double>> polygon = yPlanes[i].first;
-		if (!isInPolygon(pos2, polygon)) {
+		const vector<pair<double, double>> &polygon = yPlanes[i].first;
+		if (!isInPolygon(pos2, polygon) || isInOpening(1, yPlanes[i].second, pos)) {
 			continue;
 		}
 		return false;
@@ -135,8 +142,19 @@ bool Physics::isHorizontalAvailable(glm::vec3 &pos, glm::vec3 movement) {
 	return true;
 }
 
-bool Physics::isInPolygon(pair<double, double> pos, vector<pair<double, double>> polygon) {
+bool Physics::isInPolygon(pair<double, double> pos, const vector<pair<double, double>> &polygon) const {
 	double x = pos.first, y = pos.second;
+	// a point outside the bounds of the polygon is outside it, without summing angles
+	double minX = DBL_MAX, minY = DBL_MAX, maxX = -DBL_MAX, maxY = -DBL_MAX;
+	for (size_t i = 0; i < polygon.size(); ++i) {
+		minX = min(minX, polygon[i].first);
+		maxX = max(maxX, polygon[i].first);
+		minY = min(minY, polygon[i].second);
+		maxY = max(maxY, polygon[i].second);
+	}
+	if (x < minX || x > maxX || y < minY || y > maxY) {
+		return false;
+	}
 	double totalAngle = 0;
 	for (int i = 0; i < polygon.size(); ++i) {
 		double x1 = polygon[i].first - x;
@@ -149,7 +167,7 @@ bool Physics::isInPolygon(pair<double, double> pos, vector<pair<double, double>>
 	return (abs(totalAngle) > 6);
 }
 
-double Physics::angleBetween(double x1, double y1, double x2, double y2) {
+double Physics::angleBetween(double x1, double y1, double x2, double y2) const {
 	double sinValue = (x1 * y2 - x2 * y1) / (sqrt(x1 * x1 + y1 * y1) * sqrt(x2 * x2 + y2 * y2));
 	double cosValue = (x1 * x2 + y1 * y2) / (sqrt(x1 * x1 + y1 * y1) * sqrt(x2 * x2 + y2 * y2));
 	if (cosValue >= 1.0) {
@@ -180,7 +198,7 @@ bool Physics::isIntersected(glm::vec3 playerPos, glm::vec3 lookat, glm::vec3 &po
 			continue;
 		}
 		pair<double, double> pos2 = make_pair(y + dy * t, z + dz * t);
-		vector<pair<double, double>> polygon = xPlanes[i].first;
+		const vector<pair<double, double>> &polygon = xPlanes[i].first;
 		if (isInPolygon(pos2, polygon)) {
 			tMin = t;
 			minX = 0;
@@ -200,7 +218,7 @@ bool Physics::isIntersected(glm::vec3 playerPos, glm::vec3 lookat, glm::vec3 &po
 			continue;
 		}
 		pair<double, double> pos2 = make_pair(x + dx * t, z + dz * t);
-		vector<pair<double, double>> polygon = yPlanes[i].first;
+		const vector<pair<double, double>> &polygon = yPlanes[i].first;
 		if (isInPolygon(pos2, polygon)) {
 			tMin = t;
 			minX = 1;
@@ -220,7 +238,7 @@ bool Physics::isIntersected(glm::vec3 playerPos, glm::vec3 lookat, glm::vec3 &po
 			continue;
 		}
 		pair<double, double> pos2 = make_pair(x + dx * t, y + dy * t);
-		vector<pair<double, double>> polygon = zPlanes[i].first;
+		const vector<pair<double, double>> &polygon = zPlanes[i].first;
 		if (isInPolygon(pos2, polygon)) {
 			tMin = t;
 			minX = 2;
@@ -248,6 +266,78 @@ bool Physics::isWallWhite(int x, int y) {
 	return false;
 }
 
+bool Physics::moveBox(glm::vec3 &center, glm::vec3 halfSize, glm::vec3 &velocity, double deltaTime) const {
+	const vector<pair<vector<pair<double, double>>, double>> *planes[3] = { &xPlanes, &yPlanes, &zPlanes };
+	bool landed = false;
+	// one axis after the other, each starting where the previous ones left the box
+	for (int axis = 0; axis < 3; ++axis) {
+		double move = velocity[axis] * deltaTime;
+		if (move == 0) {
+			continue;
+		}
+		double face = center[axis] + (move > 0 ? halfSize[axis] : -halfSize[axis]);
+		double faceTarget = face + move;
+		if (blockFace(*planes[axis], axis, center, faceTarget)) {
+			if (axis == 2 && move < 0) {
+				landed = true;
+			}
+			velocity[axis] = 0.0f;
+		}
+		center[axis] += (float)(faceTarget - face);
+	}
+	return landed;
+}
+
+bool Physics::blockFace(const vector<pair<vector<pair<double, double>>, double>> &planes, int axis, glm::vec3 center, double &faceTarget) const {
+	const double epsilon = 1e-4;
+	bool blocked = false;
+	bool positive = faceTarget > center[axis];
+	// the other two coordinates of the centre, in the order the polygons of this axis use
+	pair<double, double> pos2 = (axis == 0) ? make_pair((double)center.y, (double)center.z)
+		: (axis == 1) ? make_pair((double)center.x, (double)center.z) : make_pair((double)center.x, (double)center.y);
+	for (int i = 0; i < planes.size(); ++i) {
+		double plane = planes[i].second;
+		// planes the centre hasn't passed block the face, a box that slid off an opening it sank into is lifted out
+		bool crosses = positive ? (center[axis] < plane && faceTarget > plane) : (center[axis] > plane && faceTarget < plane);
+		if (!crosses || !isInPolygon(pos2, planes[i].first) || isInOpening(axis, plane, center)) {
+			continue;
+		}
+		faceTarget = positive ? plane - epsilon : plane + epsilon;
+		blocked = true;
+	}
+	return blocked;
+}
+
+void Physics::setOpening(int id, bool open, glm::vec3 pos, glm::vec3 n, glm::vec3 up, float width, float height) {
+	if ((size_t)id >= openings.size()) {
+		WallOpening closed = WallOpening();
+		openings.resize(id + 1, closed);
+	}
+	WallOpening &opening = openings[id];
+	opening.open = open;
+	opening.pos = pos;
+	opening.n = n;
+	opening.right = glm::normalize(glm::cross(up, n));
+	opening.up = up;
+	opening.halfWidth = width / 2.0f;
+	opening.halfHeight = height / 2.0f;
+}
+
+bool Physics::isInOpening(int axis, double plane, glm::vec3 p) const {
+	for (size_t i = 0; i < openings.size(); ++i) {
+		const WallOpening &opening = openings[i];
+		// the opening has to lie in this plane, portals sit slightly in front of their wall
+		if (!opening.open || fabs(opening.n[axis]) < 0.99f || fabs(opening.pos[axis] - plane) > 0.05) {
+			continue;
+		}
+		glm::vec3 d = p - opening.pos;
+		if (fabs(glm::dot(d, opening.right)) <= opening.halfWidth && fabs(glm::dot(d, opening.up)) <= opening.halfHeight) {
+			return true;
+		}
+	}
+	return false;
+}
+
 bool Physics::isWin(glm::vec3 &pos) {
 	float dis = glm::distance(pos, winPoint);
 	return (dis < 2.0f);
@@ -15,6 +15,13 @@ using namespace std;
 
 const double g = 20.0;
 
+// a hole in a wall or floor, like a linked portal, that the player passes through instead of colliding with it
+struct WallOpening {
+	bool open;
+	glm::vec3 pos, n, right, up;
+	float halfWidth, halfHeight;
+};
+
 class Physics {
 private:
 	vector<pair<vector<pair<double, double>>, double>> xPlanes;
@@ -23,20 +30,37 @@ private:
 	glm::vec3 worldUp;
 	vector<pair<int, int>> whiteWalls;
 	glm::vec3 winPoint;
+	vector<WallOpening> openings;
 
 public:
+	// an empty map without a win point, a loaded one is moved in
+	Physics();
 	Physics(string const &path, string const &winPath, glm::vec3 up);
 	~Physics();
+	// moving hands over the planes without copying them, levels are swapped that way
+	Physics(Physics &&other) = default;
+	Physics &operator=(Physics &&other) = default;
 
 	void updateVerticleState(glm::vec3 &v, glm::vec3 &pos, double deltaTime, bool &isJumping);
 	bool isHorizontalAvailable(glm::vec3 &pos, glm::vec3 movement);
 	bool isIntersected(glm::vec3 playerPos, glm::vec3 lookat, glm::vec3 &pos, glm::vec3 &n, glm::vec3 &up);
 	bool isWin(glm::vec3 &pos);
+	bool isInPolygon(pair<double, double> pos, const vector<pair<double, double>> &polygon) const;
+	// moves an axis aligned box by velocity (z up) over deltaTime, stopping each axis at the first wall, floor or
+	// ceiling a face of the box would cross; holes let it through. Returns true if the box landed on a floor.
+	// Only reads the map, so boxes may be moved from several threads at once
+	bool moveBox(glm::vec3 &center, glm::vec3 halfSize, glm::vec3 &velocity, double deltaTime) const;
+	// opens or closes hole id in the surface at pos with normal n
+	void setOpening(int id, bool open, glm::vec3 pos, glm::vec3 n, glm::vec3 up, float width, float height);
 
 private:
-	bool isInPolygon(pair<double, double> pos, vector<pair<double, double>> polygon);
-	double angleBetween(double x1, double y1, double x2, double y2);
+	double angleBetween(double x1, double y1, double x2, double y2) const;
 	bool isWallWhite(int x, int y);
+	// whether p lies in an open hole of the plane at coordinate plane along axis (0 x, 1 y, 2 z)
+	bool isInOpening(int axis, double plane, glm::vec3 p) const;
+	// limits the move of the leading face of the box around center to faceTarget along axis to the first plane
+	// in the way, returns true if it was
+	bool blockFace(const vector<pair<vector<pair<double, double>>, double>> &planes, int axis, glm::vec3 center, double &faceTarget) const;
 };
 
 #endif // PHSICS_H
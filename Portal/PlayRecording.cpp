@@ -0,0 +1,83 @@
+#include "PlayRecording.h"
+
+PlayRecording::PlayRecording() {
+	//
+}
+
+PlayRecording::~PlayRecording() {
+	stop();
+}
+
+bool PlayRecording::start(const string &path) {
+	stop();
+	file.open(path);
+	if (!file) {
+		std::cout << "Recording failed to open at path: " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void PlayRecording::stop() {
+	if (file.is_open()) {
+		file.close();
+	}
+}
+
+bool PlayRecording::isRecording() const {
+	return file.is_open();
+}
+
+void PlayRecording::recordFrame(const PlaySample &sample) {
+	if (!file.is_open()) {
+		return;
+	}
+	file << "F " << sample.playerPos.x << " " << sample.playerPos.y << " " << sample.playerPos.z << " "
+		<< sample.speed.x << " " << sample.speed.y << " " << sample.speed.z << " "
+		<< sample.keyboardSpeed.x << " " << sample.keyboardSpeed.y << " " << sample.keyboardSpeed.z << " "
+		<< sample.front.x << " " << sample.front.y << " " << sample.front.z << " "
+		<< sample.yaw << " " << sample.pitch << " " << sample.deltaTime << "\n";
+}
+
+void PlayRecording::recordPortal(int type, glm::vec3 pos, glm::vec3 n, glm::vec3 up) {
+	if (!file.is_open()) {
+		return;
+	}
+	file << "P " << type << " " << pos.x << " " << pos.y << " " << pos.z << " "
+		<< n.x << " " << n.y << " " << n.z << " " << up.x << " " << up.y << " " << up.z << "\n";
+}
+
+bool PlayRecording::load(const string &path) {
+	ifstream inFile(path);
+	if (!inFile) {
+		std::cout << "Recording failed to load at path: " << path << std::endl;
+		return false;
+	}
+	samples.clear();
+	placements.clear();
+	string line;
+	while (getline(inFile, line)) {
+		istringstream in(line);
+		char type = 0;
+		in >> type;
+		if (type == 'F') {
+			PlaySample s;
+			in >> s.playerPos.x >> s.playerPos.y >> s.playerPos.z
+				>> s.speed.x >> s.speed.y >> s.speed.z
+				>> s.keyboardSpeed.x >> s.keyboardSpeed.y >> s.keyboardSpeed.z
+				>> s.front.x >> s.front.y >> s.front.z
+				>> s.yaw >> s.pitch >> s.deltaTime;
+			if (in) {
+				samples.push_back(s);
+			}
+		}
+		else if (type == 'P') {
+			PortalPlacement p;
+			in >> p.type >> p.pos.x >> p.pos.y >> p.pos.z >> p.n.x >> p.n.y >> p.n.z >> p.up.x >> p.up.y >> p.up.z;
+			if (in) {
+				placements.push_back(p);
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,53 @@
+#ifndef PLAY_RECORDING_H
+#define PLAY_RECORDING_H
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// the state one frame of play started from, as passed to the physics and portal queries
+struct PlaySample {
+	glm::vec3 playerPos;
+	glm::vec3 speed;
+	glm::vec3 keyboardSpeed;
+	glm::vec3 front;
+	float yaw, pitch;
+	float deltaTime;
+};
+
+struct PortalPlacement {
+	int type;
+	glm::vec3 pos, n, up;
+};
+
+// Records the frames and portal placements of a play session to a text file, and reads them
+// back so benchmarks can replay realistic inputs. Each line is a frame ("F ...") or a placement ("P ...").
+class PlayRecording {
+public:
+	vector<PlaySample> samples;
+	vector<PortalPlacement> placements;
+
+public:
+	PlayRecording();
+	~PlayRecording();
+
+	bool start(const string &path);
+	void stop();
+	bool isRecording() const;
+	void recordFrame(const PlaySample &sample);
+	void recordPortal(int type, glm::vec3 pos, glm::vec3 n, glm::vec3 up);
+
+	// replaces samples and placements with the ones of a recorded file
+	bool load(const string &path);
+
+private:
+	ofstream file;
+};
+
+#endif
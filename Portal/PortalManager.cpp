@@ -0,0 +1,286 @@
+#include "PortalManager.h"
+
+#include <algorithm>
+
+PortalManager::PortalManager(int pairCount) : count(pairCount * 2) {
+	placed.assign(count, 0);
+	linked.assign(count, 0);
+	position.assign(count, glm::vec3(0.0f));
+	normal.assign(count, glm::vec3(0.0f, 0.0f, 1.0f));
+	transform.assign(count, glm::mat4());
+	rotation.assign(count, glm::mat3());
+	corners.assign(count * 4, glm::vec3(0.0f));
+	normalX.assign(count, 0.0f);
+	normalY.assign(count, 0.0f);
+	normalZ.assign(count, 0.0f);
+	normalD.assign(count, 0.0f);
+	rightX.assign(count, 0.0f);
+	rightY.assign(count, 0.0f);
+	rightZ.assign(count, 0.0f);
+	rightD.assign(count, 0.0f);
+	upX.assign(count, 0.0f);
+	upY.assign(count, 0.0f);
+	upZ.assign(count, 0.0f);
+	upD.assign(count, 0.0f);
+	distances.assign(count, 0.0f);
+}
+
+PortalManager::~PortalManager() {
+	//
+}
+
+void PortalManager::initialize() {
+	vector<Vertex> vertices;
+	vector<unsigned int> indices;
+	vector<Texture> noTextures;
+	meshes.clear();
+	for (int i = 0; i < count; ++i) {
+		meshes.push_back(Mesh(vertices, indices, noTextures));
+	}
+	// every pair uses the same two textures, they are loaded once
+	const char *paths[2] = { "blue_portal.png", "orange_portal.png" };
+	for (int side = 0; side < 2; ++side) {
+		textures[side].id = TextureFromFile(paths[side], "Textures/", false);
+		textures[side].type = TEXTURE_DIFFUSE;
+	}
+}
+
+int PortalManager::pairCount() const {
+	return count / 2;
+}
+
+int PortalManager::portalCount() const {
+	return count;
+}
+
+int PortalManager::exit(int id) const {
+	return id ^ 1;
+}
+
+void PortalManager::setPortal(int id, glm::vec3 pos, glm::vec3 n, glm::vec3 up) {
+	placePortal(id, pos, n, up);
+	if (id >= 0 && id < count) {
+		buildMesh(id, &corners[id * 4], n);
+	}
+}
+
+void PortalManager::buildMesh(int id, const glm::vec3 *corners, glm::vec3 n) {
+	vector<Vertex> vertices;
+	vector<unsigned int> indices;
+	vector<Texture> meshTextures;
+	Vertex v[4];
+	for (int i = 0; i < 4; ++i) {
+		v[i].Position = corners[i];
+	}
+	v[0].TexCoords = glm::vec2(0.0f, 0.0f);
+	v[1].TexCoords = glm::vec2(1.0f, 0.0f);
+	v[2].TexCoords = glm::vec2(1.0f, 1.0f);
+	v[3].TexCoords = glm::vec2(0.0f, 1.0f);
+	for (int i = 0; i < 4; ++i) {
+		v[i].Normal = n;
+		vertices.push_back(v[i]);
+	}
+	int order[] = { 0, 1, 2, 0, 2, 3 };
+	for (int i = 0; i < 6; ++i) {
+		indices.push_back(order[i]);
+	}
+	meshTextures.push_back(textures[id % 2]);
+	meshes[id] = Mesh(vertices, indices, meshTextures);
+}
+
+void PortalManager::placePortal(int id, glm::vec3 pos, glm::vec3 n, glm::vec3 up) {
+	if (id < 0 || id >= count) {
+		std::cout << "No portal " << id << ", only " << count << " can be placed" << std::endl;
+		return;
+	}
+	glm::vec3 right = glm::normalize(glm::cross(up, n));
+	glm::vec3 *p = &corners[id * 4];
+	p[0] = pos + n * 0.01f + up * (portal_y / 2.0f) - right * (portal_x / 2.0f);
+	p[1] = pos + n * 0.01f + up * (portal_y / 2.0f) + right * (portal_x / 2.0f);
+	p[2] = pos + n * 0.01f - up * (portal_y / 2.0f) + right * (portal_x / 2.0f);
+	p[3] = pos + n * 0.01f - up * (portal_y / 2.0f) - right * (portal_x / 2.0f);
+	++version;
+	placed[id] = 1;
+	position[id] = pos + n * 0.01f;
+	normal[id] = n;
+	glm::vec3 o = position[id];
+	normalX[id] = n.x;
+	normalY[id] = n.y;
+	normalZ[id] = n.z;
+	normalD[id] = -glm::dot(n, o);
+	rightX[id] = right.x;
+	rightY[id] = right.y;
+	rightZ[id] = right.z;
+	rightD[id] = -glm::dot(right, o);
+	upX[id] = up.x;
+	upY[id] = up.y;
+	upZ[id] = up.z;
+	upD[id] = -glm::dot(up, o);
+	updateLink(id / 2);
+}
+
+void PortalManager::removeAll() {
+	fill(placed.begin(), placed.end(), 0);
+	fill(linked.begin(), linked.end(), 0);
+	++version;
+}
+
+void PortalManager::updateLink(int pair) {
+	int a = pair * 2, b = a + 1;
+	linked[a] = linked[b] = (placed[a] && placed[b]);
+	if (!linked[a]) {
+		return;
+	}
+	// every portal has its own space, x to the right, y up and z out of the surface; passing through one
+	// maps its space onto that of the other turned half way round the up axis, so what enters through
+	// the front leaves through the front of the other
+	glm::mat4 frame[2], toLocal[2];
+	int ids[2] = { a, b };
+	for (int i = 0; i < 2; ++i) {
+		int id = ids[i];
+		glm::vec3 n = normal[id];
+		glm::vec3 right = glm::normalize(glm::cross(glm::vec3(upX[id], upY[id], upZ[id]), n));
+		glm::vec3 up = glm::cross(n, right);
+		frame[i] = glm::mat4(glm::vec4(right, 0.0f), glm::vec4(up, 0.0f), glm::vec4(n, 0.0f), glm::vec4(position[id], 1.0f));
+		// the frame is orthonormal, its inverse is the transposed rotation with the translation undone
+		glm::mat3 inverseBasis = glm::transpose(glm::mat3(right, up, n));
+		toLocal[i] = glm::mat4(inverseBasis);
+		toLocal[i][3] = glm::vec4(-(inverseBasis * position[id]), 1.0f);
+	}
+	glm::mat4 halfTurn;
+	halfTurn[0][0] = -1.0f;
+	halfTurn[2][2] = -1.0f;
+	for (int i = 0; i < 2; ++i) {
+		transform[ids[i]] = frame[1 - i] * halfTurn * toLocal[i];
+		rotation[ids[i]] = glm::mat3(transform[ids[i]]);
+	}
+}
+
+void PortalManager::Draw(Shader shader) {
+	for (int i = 0; i < count; ++i) {
+		if (placed[i]) {
+			meshes[i].Draw(shader);
+		}
+	}
+}
+
+void PortalManager::DrawSingle(Shader shader, int id) {
+	meshes[id].Draw(shader);
+}
+
+void PortalManager::getCorners(int id, glm::vec3 *corners) {
+	for (int i = 0; i < 4; ++i) {
+		corners[i] = this->corners[id * 4 + i];
+	}
+}
+
+int PortalManager::crossedPortal(glm::vec3 a, glm::vec3 b, glm::vec3 &hit, float &timeOfImpact) const {
+	int crossed = -1;
+	float nearest = 2.0f;
+	for (int i = 0; i < count; ++i) {
+		// distances of both ends from the portal plane
+		float da = normalX[i] * a.x + normalY[i] * a.y + normalZ[i] * a.z + normalD[i];
+		float db = normalX[i] * b.x + normalY[i] * b.y + normalZ[i] * b.z + normalD[i];
+		if (!linked[i] || !(da > 0.0f && db <= 0.0f)) {
+			continue;
+		}
+		float t = da / (da - db);
+		if (t >= nearest) {
+			continue;
+		}
+		glm::vec3 p = a + (b - a) * t;
+		float x = rightX[i] * p.x + rightY[i] * p.y + rightZ[i] * p.z + rightD[i];
+		float y = upX[i] * p.x + upY[i] * p.y + upZ[i] * p.z + upD[i];
+		if (fabs(x) <= portal_x / 2.0f && fabs(y) <= portal_y / 2.0f) {
+			nearest = t;
+			crossed = i;
+			hit = p;
+		}
+	}
+	timeOfImpact = nearest;
+	return crossed;
+}
+
+int PortalManager::passPortal(glm::vec3 from, glm::vec3 &to, glm::vec3 &velocity, glm::vec3 &front, float eyeHeight, float &timeOfImpact, glm::vec3 *up) {
+	int entered = -1;
+	timeOfImpact = 1.0f;
+	for (int chain = 0; chain < PORTAL_MAX_CHAIN; ++chain) {
+		glm::vec3 hit;
+		float t;
+		int crossed = crossedPortal(from, to, hit, t);
+		if (crossed < 0) {
+			break;
+		}
+		if (entered < 0) {
+			timeOfImpact = t;
+		}
+		entered = crossed;
+		int other = exit(crossed);
+		// the motion left after the crossing goes on from the exit, turned like everything else
+		from = glm::vec3(transform[crossed] * glm::vec4(hit, 1.0f)) + normal[other] * PORTAL_EXIT_CLEARANCE;
+		to = from + rotation[crossed] * (to - hit);
+		velocity = rotation[crossed] * velocity;
+		front = rotation[crossed] * front;
+		if (up != NULL) {
+			*up = rotation[crossed] * *up;
+		}
+	}
+	if (entered < 0) {
+		return -1;
+	}
+	// step out standing in the opening instead of below the surface it is set in, unless it faces down
+	int other = exit(entered);
+	if (normal[other].z > -0.5f) {
+		float bottom = corners[other * 4].z;
+		for (int i = 1; i < 4; ++i) {
+			bottom = min(bottom, corners[other * 4 + i].z);
+		}
+		to.z = max(to.z, bottom + eyeHeight);
+	}
+	return entered;
+}
+
+void PortalManager::cutOpenings(Physics &physics) const {
+	for (int i = 0; i < count; ++i) {
+		glm::vec3 up(upX[i], upY[i], upZ[i]);
+		physics.setOpening(i, linked[i] != 0, position[i], normal[i], up, portal_x, portal_y);
+	}
+}
+
+int PortalManager::visiblePortals(const Frustum &frustum, glm::vec3 eye, int budget, int *visible) {
+	int visibleCount = 0;
+	for (int i = 0; i < count; ++i) {
+		// distance of the eye in front of the portal, only portals facing it can be looked through
+		float d = normalX[i] * eye.x + normalY[i] * eye.y + normalZ[i] * eye.z + normalD[i];
+		if (!linked[i] || d <= 0.0f) {
+			continue;
+		}
+		const glm::vec3 *p = &corners[i * 4];
+		glm::vec3 boundsMin = glm::min(glm::min(p[0], p[1]), glm::min(p[2], p[3]));
+		glm::vec3 boundsMax = glm::max(glm::max(p[0], p[1]), glm::max(p[2], p[3]));
+		if (!frustum.isBoxVisible(boundsMin, boundsMax)) {
+			continue;
+		}
+		// keep the nearest portals, sorted by insertion into the budget-sized list
+		float distance = glm::dot(position[i] - eye, position[i] - eye);
+		int slot = visibleCount;
+		while (slot > 0 && distances[slot - 1] > distance) {
+			if (slot < budget) {
+				distances[slot] = distances[slot - 1];
+				visible[slot] = visible[slot - 1];
+			}
+			--slot;
+		}
+		if (slot < budget) {
+			distances[slot] = distance;
+			visible[slot] = i;
+			visibleCount = min(visibleCount + 1, budget);
+		}
+	}
+	return visibleCount;
+}
+
+glm::mat4 PortalManager::viewThrough(int id, const glm::mat4 &view) const {
+	// the inverse of a portal transform is the transform of its exit
+	return view * transform[exit(id)];
+}
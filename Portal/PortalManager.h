@@ -0,0 +1,106 @@
+#ifndef PORTAL_MANAGER_H
+#define PORTAL_MANAGER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <stb_image.h>
+
+#include "Mesh.h"
+#include "Shader.h"
+#include "Frustum.h"
+#include "Physics.h"
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+// the two sides of a pair, portal 2 * pair + side
+#define BLUE_PORTAL 0
+#define ORANGE_PORTAL 1
+
+// size of a portal opening
+const float portal_x = 1.5f;
+const float portal_y = 2.7f;
+
+// pairs the game can place, selected with the number keys
+#define PORTAL_MAX_PAIRS 4
+
+// how far in front of the exit portal a player comes out, keeps the next sweep off the exit plane
+const float PORTAL_EXIT_CLEARANCE = 0.1f;
+// portals one tick of motion may pass through in a row
+#define PORTAL_MAX_CHAIN 4
+
+extern unsigned int TextureFromFile(const char *path, const string &directory, bool gamma);
+
+// Any number of linked portal pairs. Portal 2k and 2k + 1 form pair k and lead into each other.
+// The planes of all portals are kept as separate coordinate arrays, so a crossing test runs over
+// every portal in one pass; the transforms between the portals of a pair are built on placement.
+class PortalManager {
+public:
+	// per portal
+	vector<unsigned char> placed;
+	vector<unsigned char> linked;		// both portals of its pair are placed
+	vector<glm::vec3> position, normal;
+	vector<glm::mat4> transform;		// world through the portal to the world in front of its exit
+	vector<glm::mat3> rotation;			// rotation part of transform
+	vector<glm::vec3> corners;			// 4 per portal
+	vector<Mesh> meshes;
+	// portal planes: signed distance along the normal, right and up axes of the portal
+	vector<float> normalX, normalY, normalZ, normalD;
+	vector<float> rightX, rightY, rightZ, rightD;
+	vector<float> upX, upY, upZ, upD;
+	// incremented whenever a portal is placed, lets cached portal views know the scene changed
+	unsigned int version = 0;
+
+public:
+	PortalManager(int pairCount = PORTAL_MAX_PAIRS);
+	~PortalManager();
+
+	void initialize();
+	int pairCount() const;
+	int portalCount() const;
+	// the portal leading out of portal id
+	int exit(int id) const;
+
+	void setPortal(int id, glm::vec3 pos, glm::vec3 n, glm::vec3 up);
+	// places a portal without building its mesh
+	void placePortal(int id, glm::vec3 pos, glm::vec3 n, glm::vec3 up);
+	// takes every portal down, for a new map
+	void removeAll();
+	// builds the mesh of portal id with the given corners and normal, on the thread owning the GL context
+	void buildMesh(int id, const glm::vec3 *corners, glm::vec3 n);
+	void Draw(Shader shader);
+	void DrawSingle(Shader shader, int id);
+	// writes the four corners of portal id
+	void getCorners(int id, glm::vec3 *corners);
+
+	// the linked portal whose opening the segment from a to b enters first from the front, -1 if none;
+	// hit is where it does and timeOfImpact the fraction of the segment before it
+	int crossedPortal(glm::vec3 a, glm::vec3 b, glm::vec3 &hit, float &timeOfImpact) const;
+	// sweeps the eye over its motion of this tick, from to to. When that enters a portal the rest of the motion
+	// continues out of the exit, so to, velocity and front (and up, if given) are carried through. Returns the last
+	// portal entered or -1, timeOfImpact is the fraction of the motion done before the first crossing
+	int passPortal(glm::vec3 from, glm::vec3 &to, glm::vec3 &velocity, glm::vec3 &front, float eyeHeight, float &timeOfImpact, glm::vec3 *up = NULL);
+	// opens the walls behind the linked portals in the collision of physics, and closes the others
+	void cutOpenings(Physics &physics) const;
+	// writes the linked portals facing eye inside the frustum to visible, nearest first and at most budget of them
+	int visiblePortals(const Frustum &frustum, glm::vec3 eye, int budget, int *visible);
+	// the view of a camera looking into portal id, as seen from behind its exit
+	glm::mat4 viewThrough(int id, const glm::mat4 &view) const;
+
+private:
+	int count;
+	Texture textures[2];
+	vector<float> distances;	// scratch for visiblePortals
+
+	void updateLink(int pair);
+};
+
+#endif
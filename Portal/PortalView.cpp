@@ -0,0 +1,124 @@
+#include "PortalView.h"
+
+PortalView::PortalView() : FBO(0), colorTexture(0), depthRBO(0), width(1), height(1), textureWidth(0), textureHeight(0),
+	screenRect(-1.0f, -1.0f, 1.0f, 1.0f), qualityScale(1.0f), reuseThreshold(0.0005f), valid(false), lastWidth(0), lastHeight(0), lastSceneVersion(0), allocatedWidth(0), allocatedHeight(0) {
+	//
+}
+
+PortalView::~PortalView() {
+	//
+}
+
+void PortalView::initialize() {
+	glGenFramebuffers(1, &FBO);
+	glGenTextures(1, &colorTexture);
+	glGenRenderbuffers(1, &depthRBO);
+	textureWidth = textureHeight = 64;
+	resize(64, 64);
+}
+
+bool PortalView::updateFootprint(const glm::mat4 &viewProjection, const glm::vec3 *corners, int cornerCount, int screenWidth, int screenHeight) {
+	glm::vec2 lo(1.0f, 1.0f), hi(-1.0f, -1.0f);
+	bool behind = false;
+	for (int i = 0; i < cornerCount; ++i) {
+		glm::vec4 p = viewProjection * glm::vec4(corners[i], 1.0f);
+		if (p.w <= 0.0001f) {
+			// a corner behind the camera can project anywhere, fall back to the whole screen
+			behind = true;
+			break;
+		}
+		lo = glm::vec2(min(lo.x, p.x / p.w), min(lo.y, p.y / p.w));
+		hi = glm::vec2(max(hi.x, p.x / p.w), max(hi.y, p.y / p.w));
+	}
+	if (behind) {
+		lo = glm::vec2(-1.0f, -1.0f);
+		hi = glm::vec2(1.0f, 1.0f);
+	}
+	lo = glm::vec2(max(lo.x, -1.0f), max(lo.y, -1.0f));
+	hi = glm::vec2(min(hi.x, 1.0f), min(hi.y, 1.0f));
+	if (lo.x >= hi.x || lo.y >= hi.y) {
+		return false;
+	}
+	screenRect = glm::vec4(lo.x, lo.y, hi.x, hi.y);
+	width = max(1, (int)ceil((hi.x - lo.x) * 0.5f * screenWidth * qualityScale));
+	height = max(1, (int)ceil((hi.y - lo.y) * 0.5f * screenHeight * qualityScale));
+	if (width > textureWidth || height > textureHeight) {
+		// grow in steps so that a moving footprint doesn't reallocate every frame
+		textureWidth = max(textureWidth, (width + 127) / 128 * 128);
+		textureHeight = max(textureHeight, (height + 127) / 128 * 128);
+		valid = false;
+	}
+	return true;
+}
+
+bool PortalView::needsRender(const glm::mat4 &insideView, unsigned int sceneVersion) {
+	bool changed = !valid || sceneVersion != lastSceneVersion || width != lastWidth || height != lastHeight;
+	for (int i = 0; i < 4 && !changed; ++i) {
+		for (int j = 0; j < 4 && !changed; ++j) {
+			changed = fabs(insideView[i][j] - lastView[i][j]) > reuseThreshold;
+		}
+		changed = changed || fabs(screenRect[i] - lastRect[i]) > reuseThreshold;
+	}
+	if (!changed) {
+		return false;
+	}
+	valid = true;
+	lastView = insideView;
+	lastRect = screenRect;
+	lastWidth = width;
+	lastHeight = height;
+	lastSceneVersion = sceneVersion;
+	return true;
+}
+
+glm::mat4 PortalView::cropProjection(const glm::mat4 &projection) {
+	float sx = 2.0f / (screenRect.z - screenRect.x);
+	float sy = 2.0f / (screenRect.w - screenRect.y);
+	glm::mat4 crop;
+	crop[0][0] = sx;
+	crop[1][1] = sy;
+	crop[3][0] = -sx * (screenRect.x + screenRect.z) * 0.5f;
+	crop[3][1] = -sy * (screenRect.y + screenRect.w) * 0.5f;
+	return crop * projection;
+}
+
+void PortalView::begin(int width, int height, int textureWidth, int textureHeight) {
+	if (textureWidth != allocatedWidth || textureHeight != allocatedHeight) {
+		resize(textureWidth, textureHeight);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glViewport(0, 0, width, height);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void PortalView::end(int screenWidth, int screenHeight, unsigned int framebuffer) {
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, screenWidth, screenHeight);
+}
+
+glm::vec2 PortalView::textureScale() {
+	return glm::vec2((float)width / textureWidth, (float)height / textureHeight);
+}
+
+void PortalView::resize(int w, int h) {
+	allocatedWidth = w;
+	allocatedHeight = h;
+
+	glBindTexture(GL_TEXTURE_2D, colorTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w, h);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "Portal view framebuffer is not complete" << std::endl;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
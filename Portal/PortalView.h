@@ -0,0 +1,59 @@
+#ifndef PORTALVIEW_H
+#define PORTALVIEW_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <iostream>
+
+using namespace std;
+
+// Offscreen target for the scene seen through one portal. The texture only covers the portal's
+// footprint on screen, scaled by a quality factor, and is kept from the previous frame while
+// neither the remote camera nor the scene have changed. The footprint is worked out on the game thread,
+// begin() and end() run on the render thread, which grows the texture to the size it is given.
+class PortalView {
+public:
+	unsigned int FBO, colorTexture, depthRBO;
+	// size of the region rendered this frame and of the texture it needs
+	int width, height;
+	int textureWidth, textureHeight;
+	// footprint of the portal in normalized device coordinates (xmin, ymin, xmax, ymax)
+	glm::vec4 screenRect;
+	float qualityScale;
+	// largest per-element change of the view matrix for which the previous frame is reused
+	float reuseThreshold;
+
+public:
+	PortalView();
+	~PortalView();
+
+	void initialize();
+	// computes the footprint of the portal corners, returns false if the portal is off screen
+	bool updateFootprint(const glm::mat4 &viewProjection, const glm::vec3 *corners, int cornerCount, int screenWidth, int screenHeight);
+	// returns true if the view has to be rendered again this frame
+	bool needsRender(const glm::mat4 &insideView, unsigned int sceneVersion);
+	// projection mapping the footprint onto the whole render region
+	glm::mat4 cropProjection(const glm::mat4 &projection);
+	// binds the render target for a region of width by height in a texture of textureWidth by textureHeight,
+	// the sizes of the frame it was set up in; the caller restores the framebuffer and viewport with end()
+	void begin(int width, int height, int textureWidth, int textureHeight);
+	static void end(int screenWidth, int screenHeight, unsigned int framebuffer = 0);
+	// the part of the texture holding this frame's render region
+	glm::vec2 textureScale();
+
+private:
+	bool valid;
+	glm::mat4 lastView;
+	glm::vec4 lastRect;
+	int lastWidth, lastHeight;
+	unsigned int lastSceneVersion;
+	int allocatedWidth, allocatedHeight;	// storage of the texture, only known to the render thread
+
+	void resize(int w, int h);
+};
+
+#endif
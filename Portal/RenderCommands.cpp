@@ -0,0 +1,487 @@
+#include "RenderCommands.h"
+
+#include <new>
+#include <cstring>
+
+// payload entries start on this alignment
+const size_t PAYLOAD_ALIGNMENT = 16;
+
+static const char *commandNames[] = {
+	"viewport", "clear", "stencil", "color_write", "depth_write", "depth_test", "additive_blend", "clip_planes",
+	"use_program", "set_int", "set_bool", "set_vec2", "set_vec4", "set_mat4", "bind_texture",
+	"draw_model", "draw_chunks", "draw_instanced", "draw_portal", "draw_boxes", "draw_model_instances", "draw_overlay",
+	"upload_boxes", "upload_model_instances", "upload_model", "release_model", "upload_views", "build_portal_mesh", "begin_target", "end_target", "begin_scene", "present_scene", "begin_timer", "end_timer"
+};
+
+// what the game draws the chunks of a view with
+struct ChunkDraw {
+	glm::vec3 eye;
+	Frustum frustum;
+	bool culled;
+	const unsigned char *potentiallyVisible;
+};
+
+RenderCommandList::RenderCommandList() : drawnChunks(0), inputTime(0.0), program(NULL) {
+	//
+}
+
+void RenderCommandList::reset() {
+	commands.clear();
+	payload.clear();
+	program = NULL;
+	inputTime = 0.0;
+}
+
+int RenderCommandList::size() const {
+	return (int)commands.size();
+}
+
+RenderCommand &RenderCommandList::add(RenderCommandType type, void *object) {
+	RenderCommand command = { type, object, NULL, { 0, 0, 0, 0 }, 0 };
+	commands.push_back(command);
+	return commands.back();
+}
+
+void *RenderCommandList::addPayload(size_t size) {
+	size_t offset = (payload.size() + PAYLOAD_ALIGNMENT - 1) & ~(PAYLOAD_ALIGNMENT - 1);
+	payload.resize(offset + size);
+	commands.back().payload = offset;
+	return &payload[offset];
+}
+
+const void *RenderCommandList::payloadOf(const RenderCommand &command) const {
+	return &payload[command.payload];
+}
+
+void *RenderCommandList::payloadOf(const RenderCommand &command) {
+	return &payload[command.payload];
+}
+
+void RenderCommandList::viewport(int x, int y, int width, int height) {
+	RenderCommand &command = add(RC_VIEWPORT);
+	command.args[0] = x;
+	command.args[1] = y;
+	command.args[2] = width;
+	command.args[3] = height;
+}
+
+void RenderCommandList::clear(int flags, glm::vec4 color) {
+	add(RC_CLEAR).args[0] = flags;
+	*(glm::vec4 *)addPayload(sizeof(glm::vec4)) = color;
+}
+
+void RenderCommandList::setStencil(StencilMode mode) {
+	add(RC_STENCIL).args[0] = mode;
+}
+
+void RenderCommandList::setColorWrite(bool write) {
+	add(RC_COLOR_WRITE).args[0] = write;
+}
+
+void RenderCommandList::setDepthWrite(bool write) {
+	add(RC_DEPTH_WRITE).args[0] = write;
+}
+
+void RenderCommandList::setDepthTest(DepthTest test) {
+	add(RC_DEPTH_TEST).args[0] = test;
+}
+
+void RenderCommandList::setAdditiveBlend(bool additive) {
+	add(RC_ADDITIVE_BLEND).args[0] = additive;
+}
+
+void RenderCommandList::setClipPlanes(int count) {
+	add(RC_CLIP_PLANES).args[0] = count;
+}
+
+void RenderCommandList::useProgram(Shader *shader) {
+	program = shader;
+	add(RC_USE_PROGRAM, shader);
+}
+
+void RenderCommandList::setInt(const char *name, int value) {
+	RenderCommand &command = add(RC_SET_INT, program);
+	command.name = name;
+	command.args[0] = value;
+}
+
+void RenderCommandList::setBool(const char *name, bool value) {
+	RenderCommand &command = add(RC_SET_BOOL, program);
+	command.name = name;
+	command.args[0] = value;
+}
+
+void RenderCommandList::setVec2(const char *name, glm::vec2 value) {
+	add(RC_SET_VEC2, program).name = name;
+	*(glm::vec2 *)addPayload(sizeof(glm::vec2)) = value;
+}
+
+void RenderCommandList::setVec4(const char *name, glm::vec4 value) {
+	add(RC_SET_VEC4, program).name = name;
+	*(glm::vec4 *)addPayload(sizeof(glm::vec4)) = value;
+}
+
+void RenderCommandList::setMat4(const char *name, const glm::mat4 &value, bool latched) {
+	RenderCommand &command = add(RC_SET_MAT4, program);
+	command.name = name;
+	command.args[0] = latched;
+	*(glm::mat4 *)addPayload(sizeof(glm::mat4)) = value;
+}
+
+void RenderCommandList::bindTexture(int unit, unsigned int texture) {
+	RenderCommand &command = add(RC_BIND_TEXTURE);
+	command.args[0] = unit;
+	command.args[1] = (int)texture;
+}
+
+void RenderCommandList::drawModel(Model *model, bool countChunks) {
+	add(RC_DRAW_MODEL, model).args[0] = countChunks;
+}
+
+void RenderCommandList::drawChunks(Model *model, glm::vec3 eye, const Frustum *frustum, const unsigned char *potentiallyVisible, bool sortFrontToBack, bool countChunks) {
+	RenderCommand &command = add(RC_DRAW_CHUNKS, model);
+	command.args[0] = sortFrontToBack;
+	command.args[1] = countChunks;
+	ChunkDraw *draw = new (addPayload(sizeof(ChunkDraw))) ChunkDraw();
+	draw->eye = eye;
+	draw->culled = (frustum != NULL);
+	if (frustum != NULL) {
+		draw->frustum = *frustum;
+	}
+	draw->potentiallyVisible = potentiallyVisible;
+}
+
+void RenderCommandList::drawInstanced(Model *model, int instances) {
+	add(RC_DRAW_INSTANCED, model).args[0] = instances;
+}
+
+void RenderCommandList::drawPortal(PortalManager *portals, int id) {
+	add(RC_DRAW_PORTAL, portals).args[0] = id;
+}
+
+void RenderCommandList::drawPortals(PortalManager *portals) {
+	// only the portals placed now are drawn, later placements wait for their mesh commands
+	for (int i = 0; i < portals->portalCount(); ++i) {
+		if (portals->placed[i]) {
+			drawPortal(portals, i);
+		}
+	}
+}
+
+void RenderCommandList::drawBoxes(RigidBodyRenderer *renderer) {
+	add(RC_DRAW_BOXES, renderer);
+}
+
+void RenderCommandList::drawModelInstances(InstancedModels *models) {
+	add(RC_DRAW_MODEL_INSTANCES, models);
+}
+
+void RenderCommandList::drawOverlay(OverlayRenderer *renderer, const OverlayBatch &overlay, int screenWidth, int screenHeight) {
+	RenderCommand &command = add(RC_DRAW_OVERLAY, renderer);
+	command.args[0] = (int)overlay.vertices.size();
+	command.args[1] = screenWidth;
+	command.args[2] = screenHeight;
+	if (!overlay.vertices.empty()) {
+		memcpy(addPayload(overlay.vertices.size() * sizeof(OverlayVertex)), &overlay.vertices[0], overlay.vertices.size() * sizeof(OverlayVertex));
+	}
+}
+
+void RenderCommandList::uploadBoxes(RigidBodyRenderer *renderer, const vector<glm::vec3> &boxes) {
+	add(RC_UPLOAD_BOXES, renderer).args[0] = (int)boxes.size() / 2;
+	if (!boxes.empty()) {
+		memcpy(addPayload(boxes.size() * sizeof(glm::vec3)), &boxes[0], boxes.size() * sizeof(glm::vec3));
+	}
+}
+
+void RenderCommandList::uploadModelInstances(InstancedModels *models, const vector<ModelInstance> &instances) {
+	add(RC_UPLOAD_MODEL_INSTANCES, models).args[0] = (int)instances.size();
+	if (!instances.empty()) {
+		memcpy(addPayload(instances.size() * sizeof(ModelInstance)), &instances[0], instances.size() * sizeof(ModelInstance));
+	}
+}
+
+void RenderCommandList::uploadModel(Model *model) {
+	add(RC_UPLOAD_MODEL, model);
+}
+
+void RenderCommandList::releaseModel(Model *model) {
+	add(RC_RELEASE_MODEL, model);
+}
+
+void RenderCommandList::uploadViews(const MultiView &multiView, bool latched) {
+	add(RC_UPLOAD_VIEWS, program).args[0] = latched;
+	new (addPayload(sizeof(MultiView))) MultiView(multiView);
+}
+
+void RenderCommandList::buildPortalMesh(PortalManager *portals, int id) {
+	add(RC_BUILD_PORTAL_MESH, portals).args[0] = id;
+	glm::vec3 *placement = (glm::vec3 *)addPayload(5 * sizeof(glm::vec3));
+	portals->getCorners(id, placement);
+	placement[4] = portals->normal[id];
+}
+
+void RenderCommandList::beginTarget(PortalView *view) {
+	RenderCommand &command = add(RC_BEGIN_TARGET, view);
+	// the view is set up for the next frame while this one is replayed, its sizes are kept here
+	command.args[0] = view->width;
+	command.args[1] = view->height;
+	command.args[2] = view->textureWidth;
+	command.args[3] = view->textureHeight;
+}
+
+void RenderCommandList::endTarget(int screenWidth, int screenHeight, unsigned int framebuffer) {
+	RenderCommand &command = add(RC_END_TARGET);
+	command.args[0] = screenWidth;
+	command.args[1] = screenHeight;
+	command.args[2] = (int)framebuffer;
+}
+
+void RenderCommandList::beginScene(SceneTarget *target, int width, int height, int screenWidth, int screenHeight) {
+	RenderCommand &command = add(RC_BEGIN_SCENE, target);
+	command.args[0] = width;
+	command.args[1] = height;
+	command.args[2] = screenWidth;
+	command.args[3] = screenHeight;
+}
+
+void RenderCommandList::presentScene(SceneTarget *target, int width, int height, int screenWidth, int screenHeight) {
+	RenderCommand &command = add(RC_PRESENT_SCENE, target);
+	command.args[0] = width;
+	command.args[1] = height;
+	command.args[2] = screenWidth;
+	command.args[3] = screenHeight;
+}
+
+void RenderCommandList::beginTimer(GpuTimer *timer) {
+	add(RC_BEGIN_TIMER, timer);
+}
+
+void RenderCommandList::endTimer(GpuTimer *timer) {
+	add(RC_END_TIMER, timer);
+}
+
+void RenderCommandList::latchView(const glm::mat4 &recordedView, const glm::mat4 &latestView, const glm::mat4 &projection) {
+	// view * m becomes latestView * m, and projection * view * m becomes projection * latestView * m
+	glm::mat4 turn = latestView * glm::inverse(recordedView);
+	glm::mat4 projectedTurn = projection * turn * glm::inverse(projection);
+	for (size_t i = 0; i < commands.size(); ++i) {
+		const RenderCommand &command = commands[i];
+		if (command.args[0] == 0) {
+			continue;
+		}
+		if (command.type == RC_SET_MAT4) {
+			glm::mat4 *value = (glm::mat4 *)payloadOf(command);
+			*value = turn * *value;
+		}
+		else if (command.type == RC_UPLOAD_VIEWS) {
+			((MultiView *)payloadOf(command))->transformViews(projectedTurn);
+		}
+	}
+}
+
+void RenderCommandList::replay(FrameArena &arena) {
+	drawnChunks = 0;
+	Shader *current = NULL;		// the program draws use
+	for (size_t i = 0; i < commands.size(); ++i) {
+		const RenderCommand &command = commands[i];
+		const int *args = command.args;
+		Shader *shader = (Shader *)command.object;
+		Model *model = (Model *)command.object;
+		switch (command.type) {
+		case RC_VIEWPORT:
+			glViewport(args[0], args[1], args[2], args[3]);
+			break;
+		case RC_CLEAR: {
+			glm::vec4 color = *(const glm::vec4 *)payloadOf(command);
+			glClearColor(color.x, color.y, color.z, color.w);
+			glClearStencil(0);
+			glClear(((args[0] & CLEAR_COLOR) ? GL_COLOR_BUFFER_BIT : 0) | ((args[0] & CLEAR_DEPTH) ? GL_DEPTH_BUFFER_BIT : 0)
+				| ((args[0] & CLEAR_STENCIL) ? GL_STENCIL_BUFFER_BIT : 0));
+			break;
+		}
+		case RC_STENCIL:
+			if (args[0] == STENCIL_OFF) {
+				glDisable(GL_STENCIL_TEST);
+				break;
+			}
+			glEnable(GL_STENCIL_TEST);
+			if (args[0] == STENCIL_WRITE) {
+				glStencilFunc(GL_ALWAYS, 1, 0xFF);
+				glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+			}
+			else {
+				glStencilFunc(GL_EQUAL, (args[0] == STENCIL_INSIDE) ? 1 : 0, 0xFF);
+				glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+			}
+			break;
+		case RC_COLOR_WRITE:
+			glColorMask(args[0] != 0, args[0] != 0, args[0] != 0, args[0] != 0);
+			break;
+		case RC_DEPTH_WRITE:
+			glDepthMask(args[0] != 0);
+			break;
+		case RC_DEPTH_TEST:
+			glDepthFunc((args[0] == DEPTH_LESS_EQUAL) ? GL_LEQUAL : GL_LESS);
+			break;
+		case RC_ADDITIVE_BLEND:
+			if (args[0]) {
+				glEnable(GL_BLEND);
+				glBlendFunc(GL_ONE, GL_ONE);
+			}
+			else {
+				glDisable(GL_BLEND);
+			}
+			break;
+		case RC_CLIP_PLANES:
+			for (int plane = 0; plane < VIEW_CLIP_PLANES; ++plane) {
+				if (plane < args[0])
+					glEnable(GL_CLIP_DISTANCE0 + plane);
+				else
+					glDisable(GL_CLIP_DISTANCE0 + plane);
+			}
+			break;
+		case RC_USE_PROGRAM:
+			current = shader;
+			current->use();
+			break;
+		case RC_SET_INT:
+			shader->setInt(command.name, args[0]);
+			break;
+		case RC_SET_BOOL:
+			shader->setBool(command.name, args[0] != 0);
+			break;
+		case RC_SET_VEC2:
+			shader->setVec2(command.name, *(const glm::vec2 *)payloadOf(command));
+			break;
+		case RC_SET_VEC4:
+			shader->setVec4(command.name, *(const glm::vec4 *)payloadOf(command));
+			break;
+		case RC_SET_MAT4:
+			shader->setMat4(command.name, *(const glm::mat4 *)payloadOf(command));
+			break;
+		case RC_BIND_TEXTURE:
+			glActiveTexture(GL_TEXTURE0 + args[0]);
+			glBindTexture(GL_TEXTURE_2D, (unsigned int)args[1]);
+			break;
+		case RC_DRAW_MODEL:
+			model->Draw(*current);
+			if (args[0]) {
+				drawnChunks += (int)model->chunks.size();
+			}
+			break;
+		case RC_DRAW_CHUNKS: {
+			const ChunkDraw *draw = (const ChunkDraw *)payloadOf(command);
+			model->DrawChunks(*current, draw->eye, draw->culled ? &draw->frustum : NULL, draw->potentiallyVisible, args[0] != 0, arena);
+			if (args[1]) {
+				drawnChunks += model->visibleChunks;
+			}
+			break;
+		}
+		case RC_DRAW_INSTANCED:
+			model->DrawInstanced(*current, args[0]);
+			break;
+		case RC_DRAW_PORTAL:
+			((PortalManager *)command.object)->DrawSingle(*current, args[0]);
+			break;
+		case RC_DRAW_BOXES:
+			((RigidBodyRenderer *)command.object)->Draw();
+			break;
+		case RC_UPLOAD_BOXES: {
+			const glm::vec3 *boxes = (args[0] > 0) ? (const glm::vec3 *)payloadOf(command) : NULL;
+			// args[0] boxes of a centre and a half size each
+			((RigidBodyRenderer *)command.object)->upload(boxes, args[0]);
+			break;
+		}
+		case RC_DRAW_MODEL_INSTANCES:
+			((InstancedModels *)command.object)->Draw(*current);
+			break;
+		case RC_DRAW_OVERLAY:
+			if (args[0] > 0) {
+				((OverlayRenderer *)command.object)->Draw(*current, (const OverlayVertex *)payloadOf(command), args[0], args[1], args[2]);
+			}
+			break;
+		case RC_UPLOAD_MODEL_INSTANCES: {
+			const ModelInstance *instances = (args[0] > 0) ? (const ModelInstance *)payloadOf(command) : NULL;
+			((InstancedModels *)command.object)->upload(instances, args[0]);
+			break;
+		}
+		case RC_UPLOAD_MODEL:
+			((Model *)command.object)->upload();
+			break;
+		case RC_RELEASE_MODEL:
+			((Model *)command.object)->release();
+			delete (Model *)command.object;
+			break;
+		case RC_UPLOAD_VIEWS:
+			((const MultiView *)payloadOf(command))->upload(*current);
+			break;
+		case RC_BUILD_PORTAL_MESH: {
+			const glm::vec3 *placement = (const glm::vec3 *)payloadOf(command);
+			((PortalManager *)command.object)->buildMesh(args[0], placement, placement[4]);
+			break;
+		}
+		case RC_BEGIN_TARGET:
+			((PortalView *)command.object)->begin(args[0], args[1], args[2], args[3]);
+			break;
+		case RC_END_TARGET:
+			PortalView::end(args[0], args[1], (unsigned int)args[2]);
+			break;
+		case RC_BEGIN_SCENE:
+			((SceneTarget *)command.object)->begin(args[0], args[1], args[2], args[3]);
+			break;
+		case RC_PRESENT_SCENE:
+			((SceneTarget *)command.object)->present(args[0], args[1], args[2], args[3]);
+			break;
+		case RC_BEGIN_TIMER:
+			((GpuTimer *)command.object)->begin();
+			break;
+		case RC_END_TIMER:
+			((GpuTimer *)command.object)->end();
+			break;
+		}
+	}
+}
+
+void RenderCommandList::write(ostream &out) const {
+	for (size_t i = 0; i < commands.size(); ++i) {
+		const RenderCommand &command = commands[i];
+		out << commandNames[command.type];
+		if (command.object != NULL) {
+			out << " @" << command.object;
+		}
+		if (command.name != NULL) {
+			out << " " << command.name;
+		}
+		out << " " << command.args[0] << " " << command.args[1] << " " << command.args[2] << " " << command.args[3];
+		switch (command.type) {
+		case RC_SET_VEC2: {
+			glm::vec2 v = *(const glm::vec2 *)payloadOf(command);
+			out << " (" << v.x << ", " << v.y << ")";
+			break;
+		}
+		case RC_CLEAR:
+		case RC_SET_VEC4: {
+			glm::vec4 v = *(const glm::vec4 *)payloadOf(command);
+			out << " (" << v.x << ", " << v.y << ", " << v.z << ", " << v.w << ")";
+			break;
+		}
+		case RC_SET_MAT4: {
+			const float *m = (const float *)payloadOf(command);
+			out << " (";
+			for (int j = 0; j < 16; ++j) {
+				out << m[j] << ((j < 15) ? ", " : ")");
+			}
+			break;
+		}
+		case RC_DRAW_CHUNKS: {
+			const ChunkDraw *draw = (const ChunkDraw *)payloadOf(command);
+			out << " eye (" << draw->eye.x << ", " << draw->eye.y << ", " << draw->eye.z << ")" << (draw->culled ? " culled" : "")
+				<< (draw->potentiallyVisible != NULL ? " pvs" : "");
+			break;
+		}
+		default:
+			break;
+		}
+		out << "\n";
+	}
+}
@@ -0,0 +1,154 @@
+#ifndef RENDER_COMMANDS_H
+#define RENDER_COMMANDS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <ostream>
+
+#include "Shader.h"
+#include "Model.h"
+#include "Frustum.h"
+#include "FrameArena.h"
+#include "PortalManager.h"
+#include "PortalView.h"
+#include "MultiView.h"
+#include "GpuTimer.h"
+#include "RigidBodyRenderer.h"
+#include "InstancedModels.h"
+#include "Overlay.h"
+#include "SceneTarget.h"
+
+using namespace std;
+
+// what clear() clears
+#define CLEAR_COLOR 1
+#define CLEAR_DEPTH 2
+#define CLEAR_STENCIL 4
+
+// the stencil setups of the portal passes
+enum StencilMode {
+	STENCIL_OFF,		// no stencil test
+	STENCIL_WRITE,		// everything passes and marks its pixels with 1
+	STENCIL_OUTSIDE,	// only pixels still marked 0 pass
+	STENCIL_INSIDE		// only pixels marked 1 pass
+};
+
+enum DepthTest {
+	DEPTH_LESS,
+	DEPTH_LESS_EQUAL
+};
+
+enum RenderCommandType {
+	RC_VIEWPORT, RC_CLEAR, RC_STENCIL, RC_COLOR_WRITE, RC_DEPTH_WRITE, RC_DEPTH_TEST, RC_ADDITIVE_BLEND, RC_CLIP_PLANES,
+	RC_USE_PROGRAM, RC_SET_INT, RC_SET_BOOL, RC_SET_VEC2, RC_SET_VEC4, RC_SET_MAT4, RC_BIND_TEXTURE,
+	RC_DRAW_MODEL, RC_DRAW_CHUNKS, RC_DRAW_INSTANCED, RC_DRAW_PORTAL, RC_DRAW_BOXES, RC_DRAW_MODEL_INSTANCES, RC_DRAW_OVERLAY,
+	RC_UPLOAD_BOXES, RC_UPLOAD_MODEL_INSTANCES, RC_UPLOAD_MODEL, RC_RELEASE_MODEL, RC_UPLOAD_VIEWS, RC_BUILD_PORTAL_MESH, RC_BEGIN_TARGET, RC_END_TARGET, RC_BEGIN_SCENE, RC_PRESENT_SCENE, RC_BEGIN_TIMER, RC_END_TIMER
+};
+
+// one recorded call, values that don't fit the fixed fields live in the payload of the list
+struct RenderCommand {
+	RenderCommandType type;
+	void *object;			// the shader, model, portal view, ... the command works on
+	const char *name;		// uniform name, a string literal
+	int args[4];
+	size_t payload;			// offset of the command's data in the payload of the list
+};
+
+// Everything one frame draws, recorded by the game thread without touching GL and replayed by the render
+// thread that owns the context. Commands name render state by intent (stencil modes, depth writes, clip
+// planes) and draws by the objects drawn, so a list can also be written out as text and read offline.
+// Both arrays keep their capacity across frames, steady-state frames record without allocating.
+class RenderCommandList {
+public:
+	// chunks the map draws of the list submitted, known once it has been replayed
+	int drawnChunks;
+	// glfwGetTime() when the input the list shows was sampled last, 0 if it wasn't set
+	double inputTime;
+
+public:
+	RenderCommandList();
+
+	// empties the list for the next frame
+	void reset();
+	int size() const;
+
+	void viewport(int x, int y, int width, int height);
+	void clear(int flags, glm::vec4 color);
+	void setStencil(StencilMode mode);
+	void setColorWrite(bool write);
+	void setDepthWrite(bool write);
+	void setDepthTest(DepthTest test);
+	void setAdditiveBlend(bool additive);
+	// enables the first count clip distances
+	void setClipPlanes(int count);
+
+	// the uniforms set after it go to this program
+	void useProgram(Shader *shader);
+	void setInt(const char *name, int value);
+	void setBool(const char *name, bool value);
+	void setVec2(const char *name, glm::vec2 value);
+	void setVec4(const char *name, glm::vec4 value);
+	// a latched matrix is the view of the frame followed by other transforms, latchView() turns it
+	void setMat4(const char *name, const glm::mat4 &value, bool latched = false);
+	void bindTexture(int unit, unsigned int texture);
+
+	// countChunks adds all chunks of the model to drawnChunks
+	void drawModel(Model *model, bool countChunks = false);
+	// the frustum is copied, potentiallyVisible has to stay valid until the list is replayed;
+	// countChunks adds the chunks drawn to drawnChunks
+	void drawChunks(Model *model, glm::vec3 eye, const Frustum *frustum, const unsigned char *potentiallyVisible, bool sortFrontToBack, bool countChunks = false);
+	void drawInstanced(Model *model, int instances);
+	void drawPortal(PortalManager *portals, int id);
+	void drawPortals(PortalManager *portals);
+	void drawBoxes(RigidBodyRenderer *renderer);
+	void drawModelInstances(InstancedModels *models);
+	// copies the quads of overlay to the list, drawn over a screen of the given size with the current program
+	void drawOverlay(OverlayRenderer *renderer, const OverlayBatch &overlay, int screenWidth, int screenHeight);
+
+	// copies boxes to the list, they are uploaded when it is replayed
+	void uploadBoxes(RigidBodyRenderer *renderer, const vector<glm::vec3> &boxes);
+	// copies the instances to the list, they replace those of models when it is replayed
+	void uploadModelInstances(InstancedModels *models, const vector<ModelInstance> &instances);
+	// creates the GL objects of a model loaded with deferUpload
+	void uploadModel(Model *model);
+	// deletes the GL objects of model and then model itself, nothing may use it after
+	void releaseModel(Model *model);
+	// copies the views of multiView to the list, they are uploaded to the Views block of the current program;
+	// latched views are projections of the view of the frame followed by other transforms
+	void uploadViews(const MultiView &multiView, bool latched = false);
+	// builds the mesh of portal id from its placement when the list is replayed
+	void buildPortalMesh(PortalManager *portals, int id);
+	// renders into view until endTarget(), which goes back to framebuffer, the screen by default, with its size
+	void beginTarget(PortalView *view);
+	void endTarget(int screenWidth, int screenHeight, unsigned int framebuffer = 0);
+	// renders a region of width by height of target until presentScene() stretches it over the screen
+	void beginScene(SceneTarget *target, int width, int height, int screenWidth, int screenHeight);
+	void presentScene(SceneTarget *target, int width, int height, int screenWidth, int screenHeight);
+	void beginTimer(GpuTimer *timer);
+	void endTimer(GpuTimer *timer);
+
+	// late latch: turns every latched matrix from the view the list was recorded with to latestView, which
+	// differs from it by a rotation about the eye; projection is the one the latched views were built with
+	void latchView(const glm::mat4 &recordedView, const glm::mat4 &latestView, const glm::mat4 &projection);
+
+	// issues the GL calls of the whole list, on the thread owning the context
+	void replay(FrameArena &arena);
+	// writes one line per command
+	void write(ostream &out) const;
+
+private:
+	vector<RenderCommand> commands;
+	vector<unsigned char> payload;
+	Shader *program;		// program of the uniforms recorded next
+
+	RenderCommand &add(RenderCommandType type, void *object = NULL);
+	// reserves size bytes of payload for the last command and returns them
+	void *addPayload(size_t size);
+	const void *payloadOf(const RenderCommand &command) const;
+	void *payloadOf(const RenderCommand &command);
+};
+
+#endif
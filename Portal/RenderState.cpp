@@ -0,0 +1,14 @@
+#include "RenderState.h"
+
+void RenderState::capture(Camera &camera, const RigidBodies &bodies, bool passed) {
+	eye = camera.Position;
+	view = camera.GetViewMatrix();
+	zoom = camera.Zoom;
+	bodiesVersion = bodies.version;
+	levelPassed = passed;
+	boxes.resize(bodies.size() * 2);
+	for (int i = 0; i < bodies.size(); ++i) {
+		boxes[i * 2] = bodies.position[i];
+		boxes[i * 2 + 1] = bodies.halfSize[i];
+	}
+}
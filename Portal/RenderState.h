@@ -0,0 +1,28 @@
+#ifndef RENDER_STATE_H
+#define RENDER_STATE_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "Camera.h"
+#include "RigidBodies.h"
+
+using namespace std;
+
+// What the renderer draws of one simulated tick. The game keeps two of them: while the render loop
+// submits one, the simulation of the next tick runs on the job system and fills the other, so nothing
+// the simulation changes is read halfway through a frame.
+struct RenderState {
+	glm::vec3 eye;
+	glm::mat4 view;
+	float zoom;
+	vector<glm::vec3> boxes;	// centre and half size of every rigid body
+	unsigned int bodiesVersion;	// version of the bodies the boxes were copied from
+	bool levelPassed;			// the player reached the win point
+
+	// copies what is drawn of the camera and the bodies, the box list only reallocates when it grows
+	void capture(Camera &camera, const RigidBodies &bodies, bool passed);
+};
+
+#endif
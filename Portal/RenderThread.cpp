@@ -0,0 +1,82 @@
+#include "RenderThread.h"
+#include "AllocationCounter.h"
+
+RenderThread::RenderThread() : latencyMilliseconds(0.0f), replayMilliseconds(0.0f), window(NULL), recording(0), stopping(false), arena(256 * 1024) {
+	submitted[0] = submitted[1] = false;
+}
+
+RenderThread::~RenderThread() {
+	stop();
+}
+
+void RenderThread::start(GLFWwindow *window) {
+	this->window = window;
+	stopping = false;
+	renderer = thread(&RenderThread::loop, this);
+}
+
+RenderCommandList &RenderThread::beginFrame() {
+	unique_lock<mutex> guard(lock);
+	changed.wait(guard, [this]() { return !submitted[recording]; });
+	lists[recording].reset();
+	return lists[recording];
+}
+
+void RenderThread::submit() {
+	{
+		lock_guard<mutex> guard(lock);
+		submitted[recording] = true;
+		recording = 1 - recording;
+	}
+	changed.notify_all();
+}
+
+void RenderThread::waitIdle() {
+	unique_lock<mutex> guard(lock);
+	changed.wait(guard, [this]() { return !submitted[0] && !submitted[1]; });
+}
+
+void RenderThread::stop() {
+	if (!renderer.joinable()) {
+		return;
+	}
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+	}
+	changed.notify_all();
+	renderer.join();
+}
+
+void RenderThread::loop() {
+	glfwMakeContextCurrent(window);
+	// the driver allocates as it likes, the frame allocation check is about the game thread and its jobs
+	ignoreThreadAllocations();
+	int replaying = 0;
+	while (true) {
+		{
+			unique_lock<mutex> guard(lock);
+			changed.wait(guard, [this, replaying]() { return submitted[replaying] || stopping; });
+			if (!submitted[replaying]) {
+				break;
+			}
+		}
+		// the game thread doesn't touch a submitted list, it is read without the lock
+		arena.reset();
+		double replayStart = glfwGetTime();
+		lists[replaying].replay(arena);
+		replayMilliseconds = (float)((glfwGetTime() - replayStart) * 1000.0);
+		glfwSwapBuffers(window);
+		// the frame is on its way to the screen, the time to light up the pixels is left out
+		if (lists[replaying].inputTime > 0.0) {
+			latencyMilliseconds = (float)((glfwGetTime() - lists[replaying].inputTime) * 1000.0);
+		}
+		{
+			lock_guard<mutex> guard(lock);
+			submitted[replaying] = false;
+		}
+		changed.notify_all();
+		replaying = 1 - replaying;
+	}
+	glfwMakeContextCurrent(NULL);
+}
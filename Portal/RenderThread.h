@@ -0,0 +1,55 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include <GLFW/glfw3.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "RenderCommands.h"
+#include "FrameArena.h"
+
+using namespace std;
+
+// Owns the GL context of the window on a thread of its own and replays the command lists the game thread
+// submits, presenting each with glfwSwapBuffers. Two lists take turns: the game records one while the other
+// is replayed, so the game thread never blocks on vsync and only waits when it is two frames ahead.
+class RenderThread {
+public:
+	// of the last list presented: from its input sampled to glfwSwapBuffers() returning, and its replay alone
+	atomic<float> latencyMilliseconds;
+	atomic<float> replayMilliseconds;
+
+public:
+	RenderThread();
+	~RenderThread();
+
+	// takes over the context of window, the calling thread must have released it
+	void start(GLFWwindow *window);
+	// waits until the next list has been replayed, empties it and returns it for recording;
+	// its drawnChunks are still those of its last replay
+	RenderCommandList &beginFrame();
+	// hands the list returned by beginFrame() to the render thread
+	void submit();
+	// waits until every list submitted has been presented
+	void waitIdle();
+	// replays the lists still submitted and ends the thread, the context can be made current again after
+	void stop();
+
+private:
+	GLFWwindow *window;
+	thread renderer;
+	mutex lock;
+	condition_variable changed;
+	RenderCommandList lists[2];
+	bool submitted[2];
+	int recording;		// the list the game thread records
+	bool stopping;
+	FrameArena arena;	// scratch of the draws replayed, released every frame
+
+	void loop();
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include "RigidBodies.h"
+
+#include <cmath>
+#include <algorithm>
+
+RigidBodies::RigidBodies(Physics &physics, const PortalManager *portals, JobSystem *jobs) : physics(physics), portals(portals), jobs(jobs) {
+	restitution = 0.2f;
+	pairCount = contactCount = 0;
+	accumulator = 0.0f;
+	stepTime = 0.0f;
+	version = 0;
+}
+
+int RigidBodies::add(glm::vec3 position, glm::vec3 halfSize, glm::vec3 velocity) {
+	int id = size();
+	this->position.push_back(position);
+	this->velocity.push_back(velocity);
+	this->halfSize.push_back(halfSize);
+	grounded.push_back(0);
+	bodyBucket.push_back(0);
+	bucketBodies.push_back(0);
+	moved.push_back(0);
+	++version;
+	return id;
+}
+
+void RigidBodies::clear() {
+	position.clear();
+	velocity.clear();
+	halfSize.clear();
+	grounded.clear();
+	bodyBucket.clear();
+	bucketBodies.clear();
+	moved.clear();
+	++version;
+}
+
+int RigidBodies::size() const {
+	return (int)position.size();
+}
+
+int RigidBodies::update(float frameTime) {
+	accumulator += frameTime;
+	int steps = 0;
+	while (accumulator >= RIGID_BODY_STEP && steps < RIGID_BODY_MAX_STEPS) {
+		step(RIGID_BODY_STEP);
+		accumulator -= RIGID_BODY_STEP;
+		++steps;
+	}
+	// drop what a long frame left over rather than catching up over the next frames
+	accumulator = min(accumulator, RIGID_BODY_STEP);
+	return steps;
+}
+
+void RigidBodies::step(float deltaTime) {
+	stepTime = deltaTime;
+	if (jobs != NULL) {
+		jobs->parallelFor(size(), RIGID_BODY_JOB_GRAIN, integrateJob, this);
+	}
+	else {
+		integrateJob(this, 0, size());
+	}
+	findContacts();
+	for (int i = 0; i < size(); ++i) {
+		if (moved[i]) {
+			++version;
+			break;
+		}
+	}
+}
+
+void RigidBodies::integrateJob(void *data, int begin, int end) {
+	RigidBodies *bodies = (RigidBodies *)data;
+	for (int i = begin; i < end; ++i) {
+		bodies->integrate(i, bodies->stepTime);
+	}
+}
+
+void RigidBodies::integrate(int i, float deltaTime) {
+	glm::vec3 from = position[i];
+	velocity[i].z -= (float)g * deltaTime;
+	grounded[i] = physics.moveBox(position[i], halfSize[i], velocity[i], deltaTime);
+	if (grounded[i]) {
+		float slowDown = max(0.0f, 1.0f - RIGID_BODY_FRICTION * deltaTime);
+		velocity[i].x *= slowDown;
+		velocity[i].y *= slowDown;
+	}
+	passPortal(i, from);
+	// friction only ever shrinks the speed, a resting body stops once its moves round away
+	moved[i] = position[i] != from;
+}
+
+void RigidBodies::passPortal(int i, glm::vec3 from) {
+	if (portals == NULL) {
+		return;
+	}
+	// the centre passing a portal carries the body through, the rest of its move continues from the exit
+	glm::vec3 hit;
+	float timeOfImpact;
+	int entered = portals->crossedPortal(from, position[i], hit, timeOfImpact);
+	if (entered < 0) {
+		return;
+	}
+	int other = portals->exit(entered);
+	const glm::mat3 &rotation = portals->rotation[entered];
+	position[i] = glm::vec3(portals->transform[entered] * glm::vec4(hit, 1.0f)) + rotation * (position[i] - hit) + portals->normal[other] * PORTAL_EXIT_CLEARANCE;
+	velocity[i] = rotation * velocity[i];
+	// the box stays axis aligned, portals on the map planes turn it by quarter turns that only swap its extents
+	halfSize[i] = glm::abs(rotation * halfSize[i]);
+	grounded[i] = 0;
+}
+
+// bucket of grid cell (x, y, z), bucketMask + 1 is a power of two
+static int cellBucket(int x, int y, int z, int bucketMask) {
+	return (int)(((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u) ^ ((unsigned int)z * 83492791u)) & bucketMask;
+}
+
+void RigidBodies::findContacts() {
+	pairCount = contactCount = 0;
+	int n = size();
+	float largest = 0.0f;
+	for (int i = 0; i < n; ++i) {
+		largest = max(largest, max(halfSize[i].x, max(halfSize[i].y, halfSize[i].z)));
+	}
+	if (n < 2 || largest <= 0.0f) {
+		return;
+	}
+	// cells as wide as the largest box, touching boxes have their centres in the same or neighbouring cells
+	float cellSize = largest * 2.0f;
+	int buckets = 1;
+	while (buckets < n * 2) {
+		buckets *= 2;
+	}
+	if ((int)bucketStart.size() < buckets + 1) {
+		bucketStart.resize(buckets + 1);
+		bucketSearched.resize(buckets + 1);
+	}
+	int bucketMask = buckets - 1;
+	// counting sort of the bodies by bucket, bucket b holds bucketBodies[bucketStart[b]] up to bucketStart[b + 1]
+	fill(bucketStart.begin(), bucketStart.begin() + buckets + 1, 0);
+	fill(bucketSearched.begin(), bucketSearched.begin() + buckets, -1);
+	for (int i = 0; i < n; ++i) {
+		glm::vec3 cell = glm::floor(position[i] / cellSize);
+		bodyBucket[i] = cellBucket((int)cell.x, (int)cell.y, (int)cell.z, bucketMask);
+		++bucketStart[bodyBucket[i]];
+	}
+	for (int b = 1; b <= buckets; ++b) {
+		bucketStart[b] += bucketStart[b - 1];
+	}
+	for (int i = n - 1; i >= 0; --i) {
+		bucketBodies[--bucketStart[bodyBucket[i]]] = i;
+	}
+
+	for (int a = 0; a < n; ++a) {
+		glm::vec3 cell = glm::floor(position[a] / cellSize);
+		for (int dz = -1; dz <= 1; ++dz) {
+			for (int dy = -1; dy <= 1; ++dy) {
+				for (int dx = -1; dx <= 1; ++dx) {
+					int bucket = cellBucket((int)cell.x + dx, (int)cell.y + dy, (int)cell.z + dz, bucketMask);
+					// neighbouring cells may share a bucket, each bucket is searched once per body
+					if (bucketSearched[bucket] == a) {
+						continue;
+					}
+					bucketSearched[bucket] = a;
+					for (int k = bucketStart[bucket]; k < bucketStart[bucket + 1]; ++k) {
+						int b = bucketBodies[k];
+						if (b <= a) {
+							continue;
+						}
+						++pairCount;
+						glm::vec3 d = glm::abs(position[b] - position[a]);
+						glm::vec3 reach = halfSize[a] + halfSize[b];
+						if (d.x < reach.x && d.y < reach.y && d.z < reach.z) {
+							++contactCount;
+							separate(a, b);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void RigidBodies::separate(int a, int b) {
+	glm::vec3 d = position[b] - position[a];
+	glm::vec3 overlap = halfSize[a] + halfSize[b] - glm::abs(d);
+	// push apart along the axis they overlap least on
+	int axis = 0;
+	if (overlap.y < overlap[axis]) {
+		axis = 1;
+	}
+	if (overlap.z < overlap[axis]) {
+		axis = 2;
+	}
+	float direction = (d[axis] < 0.0f) ? -1.0f : 1.0f;
+	float shareA = 0.5f, shareB = 0.5f;
+	// a body on the floor holds the one on top of it, which takes the whole correction
+	if (axis == 2) {
+		int lower = (direction > 0.0f) ? a : b;
+		int upper = (lower == a) ? b : a;
+		if (grounded[lower]) {
+			shareA = (lower == a) ? 0.0f : 1.0f;
+			shareB = 1.0f - shareA;
+			grounded[upper] = 1;
+		}
+	}
+	// the corrections are moves against the map too, so bodies aren't pushed into walls
+	glm::vec3 moveA(0.0f), moveB(0.0f);
+	moveA[axis] = -direction * overlap[axis] * shareA;
+	moveB[axis] = direction * overlap[axis] * shareB;
+	// and may push a body over an opening into its portal
+	if (shareA > 0.0f) {
+		glm::vec3 from = position[a];
+		physics.moveBox(position[a], halfSize[a], moveA, 1.0);
+		passPortal(a, from);
+		moved[a] = 1;
+	}
+	if (shareB > 0.0f) {
+		glm::vec3 from = position[b];
+		physics.moveBox(position[b], halfSize[b], moveB, 1.0);
+		passPortal(b, from);
+		moved[b] = 1;
+	}
+	// equal masses: the approaching speed is split between them, less what restitution keeps
+	float approach = (velocity[a][axis] - velocity[b][axis]) * direction;
+	if (approach > 0.0f) {
+		float impulse = approach * (1.0f + restitution) * 0.5f;
+		velocity[a][axis] -= direction * impulse;
+		velocity[b][axis] += direction * impulse;
+	}
+}
@@ -0,0 +1,68 @@
+#ifndef RIGID_BODIES_H
+#define RIGID_BODIES_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "Physics.h"
+#include "PortalManager.h"
+#include "JobSystem.h"
+
+using namespace std;
+
+// the bodies advance in steps of this length, a frame runs as many as its time covers
+const float RIGID_BODY_STEP = 1.0f / 120.0f;
+// steps one frame may run at most, a longer frame slows the bodies down instead of stalling the game
+#define RIGID_BODY_MAX_STEPS 8
+// how quickly bodies on a floor stop sliding, per second
+const float RIGID_BODY_FRICTION = 4.0f;
+// bodies one job moves at least
+#define RIGID_BODY_JOB_GRAIN 64
+
+// Axis aligned boxes like cubes and other props, moved by gravity, stopped by the map planes of Physics,
+// pushed apart from each other and carried through linked portals. The state is kept as separate arrays
+// per quantity. Pairs of bodies are found with a hashed uniform grid as wide as the largest box, so only
+// the bodies in the 27 cells around a body are tested against it. Given a job system the bodies are moved
+// in parallel, each body only reads the map and writes its own state; contacts are resolved in order after.
+class RigidBodies {
+public:
+	vector<glm::vec3> position, velocity;	// velocity has z up
+	vector<glm::vec3> halfSize;
+	vector<unsigned char> grounded;			// resting on a floor since the last step
+	float restitution;						// share of the approaching speed bodies bounce off each other with
+	// pairs sharing neighbouring grid cells and pairs actually touching in the last step
+	int pairCount, contactCount;
+	// incremented whenever bodies are added or removed and after every step that moved one
+	unsigned int version;
+
+public:
+	RigidBodies(Physics &physics, const PortalManager *portals, JobSystem *jobs = NULL);
+
+	int add(glm::vec3 position, glm::vec3 halfSize, glm::vec3 velocity);
+	void clear();
+	int size() const;
+	// runs the fixed steps covering frameTime, the rest carries over to the next frame; returns the steps run
+	int update(float frameTime);
+	void step(float deltaTime);
+
+private:
+	Physics &physics;
+	const PortalManager *portals;
+	JobSystem *jobs;
+	float accumulator;
+	float stepTime;		// length of the step being run, for the integrate jobs
+	// the grid, rebuilt every step: bodies sorted by the bucket of their cell
+	vector<int> bodyBucket, bucketStart, bucketBodies;
+	vector<int> bucketSearched;	// last body whose neighbourhood included the bucket
+	vector<unsigned char> moved;	// changed position in the step being run
+
+	void integrate(int i, float deltaTime);
+	static void integrateJob(void *data, int begin, int end);
+	// carries body i through the portal its centre entered moving from from, if any
+	void passPortal(int i, glm::vec3 from);
+	void findContacts();
+	void separate(int a, int b);
+};
+
+#endif
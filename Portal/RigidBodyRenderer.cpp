@@ -0,0 +1,80 @@
+#include "RigidBodyRenderer.h"
+
+#include <algorithm>
+
+RigidBodyRenderer::RigidBodyRenderer() : VAO(0), cubeVBO(0), instanceVBO(0), instanceCount(0), capacity(0) {
+	//
+}
+
+RigidBodyRenderer::~RigidBodyRenderer() {
+	//
+}
+
+void RigidBodyRenderer::initialize() {
+	// a cube from -1 to 1, position and normal per vertex
+	float cube[6 * 6 * 6];
+	const glm::vec3 normals[6] = {
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+	const float corners[6][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, -1 }, { 1, 1 }, { -1, 1 } };
+	int k = 0;
+	for (int face = 0; face < 6; ++face) {
+		glm::vec3 n = normals[face];
+		glm::vec3 u = (n.x != 0.0f) ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+		glm::vec3 v = glm::cross(n, u);
+		for (int i = 0; i < 6; ++i) {
+			glm::vec3 p = n + u * corners[i][0] + v * corners[i][1];
+			cube[k++] = p.x;
+			cube[k++] = p.y;
+			cube[k++] = p.z;
+			cube[k++] = n.x;
+			cube[k++] = n.y;
+			cube[k++] = n.z;
+		}
+	}
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &cubeVBO);
+	glGenBuffers(1, &instanceVBO);
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(cube), cube, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+	// centre and half size of the box, once per instance
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), (void*)0);
+	glVertexAttribDivisor(3, 1);
+	glEnableVertexAttribArray(4);
+	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), (void*)sizeof(glm::vec3));
+	glVertexAttribDivisor(4, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void RigidBodyRenderer::upload(const glm::vec3 *boxes, int count) {
+	instanceCount = count;
+	if (instanceCount == 0) {
+		return;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	if (instanceCount > capacity) {
+		// grows by doubling, so spawning bodies one by one reallocates rarely
+		capacity = max(instanceCount, capacity * 2);
+		glBufferData(GL_ARRAY_BUFFER, capacity * 2 * sizeof(glm::vec3), NULL, GL_DYNAMIC_DRAW);
+	}
+	glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * 2 * sizeof(glm::vec3), boxes);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void RigidBodyRenderer::Draw() {
+	if (instanceCount == 0) {
+		return;
+	}
+	glBindVertexArray(VAO);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 36, instanceCount);
+	glBindVertexArray(0);
+}
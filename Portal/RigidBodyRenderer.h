@@ -0,0 +1,33 @@
+#ifndef RIGID_BODY_RENDERER_H
+#define RIGID_BODY_RENDERER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+using namespace std;
+
+// Draws all rigid bodies with one instanced draw of a unit cube. The boxes are copied to the instance
+// buffer once per frame, every view of the frame, portal views included, draws from the same buffer.
+class RigidBodyRenderer {
+public:
+	unsigned int VAO, cubeVBO, instanceVBO;
+	int instanceCount;
+
+public:
+	RigidBodyRenderer();
+	~RigidBodyRenderer();
+
+	void initialize();
+	// copies count boxes, the centre and half size of each box in turn, to the instance buffer
+	void upload(const glm::vec3 *boxes, int count);
+	// draws the boxes with the program in use, shader_box.vs with its transformations set
+	void Draw();
+
+private:
+	int capacity;
+};
+
+#endif
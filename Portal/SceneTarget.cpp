@@ -0,0 +1,73 @@
+#include "SceneTarget.h"
+
+#include <cmath>
+#include <algorithm>
+
+SceneTarget::SceneTarget() : FBO(0), colorTexture(0), depthRBO(0), scale(1.0f), minScale(0.5f), targetMilliseconds(14.0f),
+	allocatedWidth(0), allocatedHeight(0) {
+	//
+}
+
+SceneTarget::~SceneTarget() {
+	//
+}
+
+void SceneTarget::initialize() {
+	glGenFramebuffers(1, &FBO);
+	glGenTextures(1, &colorTexture);
+	glGenRenderbuffers(1, &depthRBO);
+	resize(64, 64);
+}
+
+void SceneTarget::update(int screenWidth, int screenHeight, float measured, int &width, int &height) {
+	// the GPU time follows the pixel count, the square of the scale; within 10% of the target it is left alone,
+	// and it moves a part of the way only, as the measurements lag a few frames behind
+	if (measured > 0.0f && fabs(measured - targetMilliseconds) > targetMilliseconds * 0.1f) {
+		float wanted = scale * sqrt(targetMilliseconds / measured);
+		scale += (wanted - scale) * 0.2f;
+		scale = min(max(scale, minScale), 1.0f);
+	}
+	width = max(1, (int)(screenWidth * scale + 0.5f));
+	height = max(1, (int)(screenHeight * scale + 0.5f));
+}
+
+void SceneTarget::begin(int width, int height, int screenWidth, int screenHeight) {
+	if (screenWidth > allocatedWidth || screenHeight > allocatedHeight) {
+		resize(max(screenWidth, allocatedWidth), max(screenHeight, allocatedHeight));
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glViewport(0, 0, width, height);
+}
+
+void SceneTarget::present(int width, int height, int screenWidth, int screenHeight) {
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, screenWidth, screenHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, screenWidth, screenHeight);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void SceneTarget::resize(int w, int h) {
+	allocatedWidth = w;
+	allocatedHeight = h;
+
+	glBindTexture(GL_TEXTURE_2D, colorTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w, h);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "Scene framebuffer is not complete" << std::endl;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
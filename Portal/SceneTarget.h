@@ -0,0 +1,42 @@
+#ifndef SCENE_TARGET_H
+#define SCENE_TARGET_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+using namespace std;
+
+// Offscreen target the scene and the portals are rendered into at a fraction of the window resolution and
+// then stretched over the window, so the GPU time of a frame can be traded for sharpness. update() runs on
+// the game thread and moves the fraction towards the target GPU time, measured by the caller as the time the
+// GPU is busy with the passes, not including any time it waits for commands; begin() and present() run on
+// the render thread, which grows the storage to the window.
+class SceneTarget {
+public:
+	unsigned int FBO, colorTexture, depthRBO;
+	// fraction of the window resolution along each axis
+	float scale;
+	float minScale;
+	float targetMilliseconds;
+
+public:
+	SceneTarget();
+	~SceneTarget();
+
+	void initialize();
+	// adapts scale to busyMilliseconds, the GPU time of the passes drawn into the target, 0 if not known yet,
+	// and returns the size to render for a window of screenWidth by screenHeight
+	void update(int screenWidth, int screenHeight, float busyMilliseconds, int &width, int &height);
+	// binds the target for a region of width by height, the storage grows to the window size
+	void begin(int width, int height, int screenWidth, int screenHeight);
+	// stretches the region over the window and leaves the window bound, with its depth cleared for the overlay
+	void present(int width, int height, int screenWidth, int screenHeight);
+
+private:
+	int allocatedWidth, allocatedHeight;	// storage, only known to the render thread
+
+	void resize(int w, int h);
+};
+
+#endif
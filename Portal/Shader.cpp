@@ -1,46 +1,111 @@
 #include "Shader.h"
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath) {
+#include <vector>
+#include <cstdio>
+
+// reads the whole file at path into code with a single read
+static bool readSource(const char *path, std::string &code) {
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	file.seekg(0, std::ios::end);
+	code.resize((size_t)file.tellg());
+	file.seekg(0, std::ios::beg);
+	if (!code.empty()) {
+		file.read(&code[0], code.size());
+	}
+	return !file.fail();
+}
+
+// FNV-1a, the text includes its terminating zero so the concatenation of the parts can't collide
+static unsigned long long hashText(unsigned long long hash, const char *text) {
+	if (text == nullptr) {
+		text = "";
+	}
+	do {
+		hash ^= (unsigned char)*text;
+		hash *= 1099511628211ull;
+	} while (*text++ != '\0');
+	return hash;
+}
+
+// turns "A B=1" into "#define A\n#define B 1\n"
+static std::string defineLines(const char *defines) {
+	std::string lines;
+	std::istringstream names(defines != nullptr ? defines : "");
+	std::string name;
+	while (names >> name) {
+		size_t equals = name.find('=');
+		if (equals != std::string::npos) {
+			name[equals] = ' ';
+		}
+		lines += "#define " + name + "\n";
+	}
+	return lines;
+}
+
+// puts the defines after the #version line, #line keeps the line numbers of compile errors those of the file
+static void addDefines(std::string &code, const std::string &lines) {
+	if (lines.empty()) {
+		return;
+	}
+	size_t versionEnd = code.find('\n');
+	if (versionEnd == std::string::npos) {
+		versionEnd = code.size();
+	}
+	code.insert(versionEnd, "\n" + lines + "#line 2");
+}
+
+static bool programBinarySupported() {
+#ifdef GL_ARB_get_program_binary
+	if (!GLAD_GL_ARB_get_program_binary) {
+		return false;
+	}
+	// drivers may expose the extension without any format they can store
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+#else
+	return false;
+#endif
+}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath, const char* defines) {
 	// 1. retrieve the vertex/fragment source code from filePath
 	std::string vertexCode;
 	std::string fragmentCode;
 	std::string geometryCode;
-	std::ifstream vShaderFile;
-	std::ifstream fShaderFile;
-	std::ifstream gShaderFile;
-	// ensure ifstream objects can throw exceptions:
-	vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	try
-	{
-		// open files
-		vShaderFile.open(vertexPath);
-		fShaderFile.open(fragmentPath);
-		std::stringstream vShaderStream, fShaderStream;
-		// read file's buffer contents into streams
-		vShaderStream << vShaderFile.rdbuf();
-		fShaderStream << fShaderFile.rdbuf();
-		// close file handlers
-		vShaderFile.close();
-		fShaderFile.close();
-		// convert stream into string
-		vertexCode = vShaderStream.str();
-		fragmentCode = fShaderStream.str();
-		// if geometry shader path is present, also load a geometry shader
-		if (geometryPath != nullptr)
-		{
-			gShaderFile.open(geometryPath);
-			std::stringstream gShaderStream;
-			gShaderStream << gShaderFile.rdbuf();
-			gShaderFile.close();
-			geometryCode = gShaderStream.str();
-		}
-	}
-	catch (std::ifstream::failure e)
+	if (!readSource(vertexPath, vertexCode) || !readSource(fragmentPath, fragmentCode) ||
+		(geometryPath != nullptr && !readSource(geometryPath, geometryCode)))
 	{
 		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 	}
+	std::string lines = defineLines(defines);
+	addDefines(vertexCode, lines);
+	addDefines(fragmentCode, lines);
+	if (geometryPath != nullptr)
+		addDefines(geometryCode, lines);
+	// a binary linked by the same driver from the same sources skips compiling and linking
+	bool useCache = programBinarySupported();
+	std::string cachePath = std::string(vertexPath) + "+" + fragmentPath + (geometryPath != nullptr ? std::string("+") + geometryPath : std::string());
+	if (!lines.empty()) {
+		// every permutation has a file of its own
+		char permutation[16];
+		snprintf(permutation, sizeof(permutation), ".%08x", (unsigned int)hashText(14695981039346656037ull, lines.c_str()));
+		cachePath += permutation;
+	}
+	cachePath += ".programbin";
+	unsigned long long key = 14695981039346656037ull;
+	key = hashText(key, vertexCode.c_str());
+	key = hashText(key, fragmentCode.c_str());
+	key = hashText(key, geometryCode.c_str());
+	key = hashText(key, (const char *)glGetString(GL_VENDOR));
+	key = hashText(key, (const char *)glGetString(GL_RENDERER));
+	key = hashText(key, (const char *)glGetString(GL_VERSION));
+	if (useCache && loadBinary(cachePath, key)) {
+		return;
+	}
 	const char* vShaderCode = vertexCode.c_str();
 	const char * fShaderCode = fragmentCode.c_str();
 	// 2. compile shaders
@@ -73,6 +138,10 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath, const char* geo
 	glAttachShader(ID, fragment);
 	if (geometryPath != nullptr)
 		glAttachShader(ID, geometry);
+#ifdef GL_ARB_get_program_binary
+	if (useCache)
+		glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
 	glLinkProgram(ID);
 	checkCompileErrors(ID, "PROGRAM");
 	// delete the shaders as they're linked into our program now and no longer necessery
@@ -80,58 +149,60 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath, const char* geo
 	glDeleteShader(fragment);
 	if (geometryPath != nullptr)
 		glDeleteShader(geometry);
+	if (useCache)
+		saveBinary(cachePath, key);
 }
 
 void Shader::use() {
 	glUseProgram(ID);
 }
 
-void Shader::setBool(const std::string &name, bool value) const {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+void Shader::setBool(const char *name, bool value) const {
+	glUniform1i(glGetUniformLocation(ID, name), (int)value);
 }
 
-void Shader::setInt(const std::string &name, int value) const {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+void Shader::setInt(const char *name, int value) const {
+	glUniform1i(glGetUniformLocation(ID, name), value);
 }
 
-void Shader::setFloat(const std::string &name, float value) const {
-	glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+void Shader::setFloat(const char *name, float value) const {
+	glUniform1f(glGetUniformLocation(ID, name), value);
 }
 
-void Shader::setVec2(const std::string &name, const glm::vec2 &value) const {
-	glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+void Shader::setVec2(const char *name, const glm::vec2 &value) const {
+	glUniform2fv(glGetUniformLocation(ID, name), 1, &value[0]);
 }
 
-void Shader::setVec2(const std::string &name, float x, float y) const {
-	glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+void Shader::setVec2(const char *name, float x, float y) const {
+	glUniform2f(glGetUniformLocation(ID, name), x, y);
 }
 
-void Shader::setVec3(const std::string &name, const glm::vec3 &value) const {
-	glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+void Shader::setVec3(const char *name, const glm::vec3 &value) const {
+	glUniform3fv(glGetUniformLocation(ID, name), 1, &value[0]);
 }
 
-void Shader::setVec3(const std::string &name, float x, float y, float z) const {
-	glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+void Shader::setVec3(const char *name, float x, float y, float z) const {
+	glUniform3f(glGetUniformLocation(ID, name), x, y, z);
 }
 
-void Shader::setVec4(const std::string &name, const glm::vec4 &value) const {
-	glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+void Shader::setVec4(const char *name, const glm::vec4 &value) const {
+	glUniform4fv(glGetUniformLocation(ID, name), 1, &value[0]);
 }
 
-void Shader::setVec4(const std::string &name, float x, float y, float z, float w) {
-	glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+void Shader::setVec4(const char *name, float x, float y, float z, float w) {
+	glUniform4f(glGetUniformLocation(ID, name), x, y, z, w);
 }
 
-void Shader::setMat2(const std::string &name, const glm::mat2 &mat) const {
-	glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+void Shader::setMat2(const char *name, const glm::mat2 &mat) const {
+	glUniformMatrix2fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
 }
 
-void Shader::setMat3(const std::string &name, const glm::mat3 &mat) const {
-	glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+void Shader::setMat3(const char *name, const glm::mat3 &mat) const {
+	glUniformMatrix3fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
 }
 
-void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const {
-	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+void Shader::setMat4(const char *name, const glm::mat4 &mat) const {
+	glUniformMatrix4fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::checkCompileErrors(GLuint shader, std::string type) {
@@ -156,3 +227,59 @@ void Shader::checkCompileErrors(GLuint shader, std::string type) {
 		}
 	}
 }
+
+// cache file: key, binary format, binary length, binary
+bool Shader::loadBinary(const std::string &cachePath, unsigned long long key) {
+#ifdef GL_ARB_get_program_binary
+	std::ifstream file(cachePath.c_str(), std::ios::in | std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	unsigned long long fileKey = 0;
+	GLenum format = 0;
+	GLint length = 0;
+	file.read((char *)&fileKey, sizeof(fileKey));
+	file.read((char *)&format, sizeof(format));
+	file.read((char *)&length, sizeof(length));
+	if (!file || fileKey != key || length <= 0) {
+		return false;
+	}
+	std::vector<char> binary(length);
+	file.read(&binary[0], length);
+	if (!file) {
+		return false;
+	}
+	ID = glCreateProgram();
+	glProgramBinary(ID, format, &binary[0], length);
+	GLint success = 0;
+	glGetProgramiv(ID, GL_LINK_STATUS, &success);
+	if (success) {
+		return true;
+	}
+	// a driver may still reject the binary, the program is built from source and the cache rewritten
+	glDeleteProgram(ID);
+#endif
+	return false;
+}
+
+void Shader::saveBinary(const std::string &cachePath, unsigned long long key) {
+#ifdef GL_ARB_get_program_binary
+	GLint success = 0, length = 0;
+	glGetProgramiv(ID, GL_LINK_STATUS, &success);
+	glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (!success || length <= 0) {
+		return;
+	}
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(ID, length, NULL, &format, &binary[0]);
+	std::ofstream file(cachePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	file.write((const char *)&key, sizeof(key));
+	file.write((const char *)&format, sizeof(format));
+	file.write((const char *)&length, sizeof(length));
+	file.write(&binary[0], length);
+	if (!file) {
+		std::cout << "ERROR::SHADER::PROGRAM_BINARY_NOT_WRITTEN " << cachePath << std::endl;
+	}
+#endif
+}
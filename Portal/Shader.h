@@ -9,30 +9,37 @@
 #include <sstream>
 #include <iostream>
 
+// Linked programs are kept in <vertex>+<fragment>.programbin next to the sources when the driver supports
+// program binaries, keyed by the sources and the driver; a matching binary is loaded instead of compiling.
+// One source can build several programs: defines lists the macros of a permutation, separated by spaces,
+// as NAME or NAME=VALUE, and they are defined in every stage right after its #version line.
 class Shader
 {
 public:
 	unsigned int ID;
-	// constructor generates the shader on the fly
-	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr);
+	// constructor generates the shader on the fly, or loads it from the program binary cache
+	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr, const char* defines = nullptr);
 	// activate the shader
 	void use();
-	// utility uniform functions
-	void setBool(const std::string &name, bool value) const;
-	void setInt(const std::string &name, int value) const;
-	void setFloat(const std::string &name, float value) const;
-	void setVec2(const std::string &name, const glm::vec2 &value) const;
-	void setVec2(const std::string &name, float x, float y) const;
-	void setVec3(const std::string &name, const glm::vec3 &value) const;
-	void setVec3(const std::string &name, float x, float y, float z) const;
-	void setVec4(const std::string &name, const glm::vec4 &value) const;
-	void setVec4(const std::string &name, float x, float y, float z, float w);
-	void setMat2(const std::string &name, const glm::mat2 &mat) const;
-	void setMat3(const std::string &name, const glm::mat3 &mat) const;
-	void setMat4(const std::string &name, const glm::mat4 &mat) const;
+	// utility uniform functions, the names are plain C strings so setting a uniform doesn't allocate
+	void setBool(const char *name, bool value) const;
+	void setInt(const char *name, int value) const;
+	void setFloat(const char *name, float value) const;
+	void setVec2(const char *name, const glm::vec2 &value) const;
+	void setVec2(const char *name, float x, float y) const;
+	void setVec3(const char *name, const glm::vec3 &value) const;
+	void setVec3(const char *name, float x, float y, float z) const;
+	void setVec4(const char *name, const glm::vec4 &value) const;
+	void setVec4(const char *name, float x, float y, float z, float w);
+	void setMat2(const char *name, const glm::mat2 &mat) const;
+	void setMat3(const char *name, const glm::mat3 &mat) const;
+	void setMat4(const char *name, const glm::mat4 &mat) const;
 
 private:
 	// utility function for checking shader compilation/linking errors.
 	void checkCompileErrors(GLuint shader, std::string type);
+	// the program binary cache, loadBinary leaves ID a linked program when it returns true
+	bool loadBinary(const std::string &cachePath, unsigned long long key);
+	void saveBinary(const std::string &cachePath, unsigned long long key);
 };
 #endif
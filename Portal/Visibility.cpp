@@ -0,0 +1,233 @@
+#include "Visibility.h"
+#include "Model.h"
+
+PVS::PVS() : originX(0), originY(0), gridWidth(0), gridHeight(0), cellSize(1.0f), minZ(0.0f), maxZ(0.0f), chunkCount(0) {
+	//
+}
+
+void PVS::build(const vector<Vertex> &vertices, const vector<unsigned int> &indices, const vector<MapChunk> &chunks, float size) {
+	if (chunks.empty()) {
+		return;
+	}
+	cellSize = size;
+	glm::vec3 mapMin(FLT_MAX), mapMax(-FLT_MAX);
+	for (unsigned int i = 0; i < chunks.size(); ++i) {
+		mapMin = glm::min(mapMin, chunks[i].boundsMin);
+		mapMax = glm::max(mapMax, chunks[i].boundsMax);
+	}
+	originX = (int)floor(mapMin.x / cellSize);
+	originY = (int)floor(mapMin.y / cellSize);
+	// bounds ending exactly on a cell border don't reach into the next cell
+	gridWidth = max((int)floor((mapMax.x - 0.0001f) / cellSize) - originX + 1, 1);
+	gridHeight = max((int)floor((mapMax.y - 0.0001f) / cellSize) - originY + 1, 1);
+	minZ = mapMin.z;
+	maxZ = mapMax.z;
+	int cellCount = gridWidth * gridHeight;
+	if (cellCount > PVS_MAX_CELLS) {
+		std::cout << "PVS skipped, map has " << cellCount << " cells" << std::endl;
+		gridWidth = gridHeight = 0;
+		return;
+	}
+
+	// every quad is an occluder, registered in all cells its bounds overlap
+	cellQuads.assign(cellCount, vector<unsigned int>());
+	for (unsigned int i = 0; i + 5 < indices.size(); i += 6) {
+		unsigned int q = quads.size() / 4;
+		glm::vec3 p[4] = { vertices[indices[i]].Position, vertices[indices[i + 1]].Position, vertices[indices[i + 2]].Position, vertices[indices[i + 5]].Position };
+		glm::vec3 qMin(FLT_MAX), qMax(-FLT_MAX);
+		for (int j = 0; j < 4; ++j) {
+			quads.push_back(p[j]);
+			qMin = glm::min(qMin, p[j]);
+			qMax = glm::max(qMax, p[j]);
+		}
+		quadNormals.push_back(glm::normalize(glm::cross(p[1] - p[0], p[3] - p[0])));
+		int x0 = max((int)floor(qMin.x / cellSize) - originX, 0), x1 = min((int)floor(qMax.x / cellSize) - originX, gridWidth - 1);
+		int y0 = max((int)floor(qMin.y / cellSize) - originY, 0), y1 = min((int)floor(qMax.y / cellSize) - originY, gridHeight - 1);
+		for (int y = y0; y <= y1; ++y) {
+			for (int x = x0; x <= x1; ++x) {
+				cellQuads[y * gridWidth + x].push_back(q);
+			}
+		}
+	}
+
+	// the faces between neighbouring cells, from the floor to the ceiling of the map
+	openX.assign(cellCount, 0);
+	openY.assign(cellCount, 0);
+	for (int y = 0; y < gridHeight; ++y) {
+		for (int x = 0; x < gridWidth; ++x) {
+			int cell = y * gridWidth + x;
+			float cellX = (originX + x) * cellSize, cellY = (originY + y) * cellSize;
+			if (x + 1 < gridWidth) {
+				openX[cell] = !isFaceCovered(cell, cell + 1, 0, cellX + cellSize, glm::vec2(cellY, minZ), glm::vec2(cellY + cellSize, maxZ));
+			}
+			if (y + 1 < gridHeight) {
+				openY[cell] = !isFaceCovered(cell, cell + gridWidth, 1, cellY + cellSize, glm::vec2(cellX, minZ), glm::vec2(cellX + cellSize, maxZ));
+			}
+		}
+	}
+
+	cellVisibility.assign(cellCount * cellCount, 0);
+	for (int a = 0; a < cellCount; ++a) {
+		unsigned char *visible = &cellVisibility[a * cellCount];
+		int ax = a % gridWidth, ay = a / gridWidth;
+		floodQuadrant(ax, ay, 1, 1, visible);
+		floodQuadrant(ax, ay, -1, 1, visible);
+		floodQuadrant(ax, ay, 1, -1, visible);
+		floodQuadrant(ax, ay, -1, -1, visible);
+		// a cell always sees its direct neighbours, lines through the corner they share included
+		for (int y = max(ay - 1, 0); y <= min(ay + 1, gridHeight - 1); ++y) {
+			for (int x = max(ax - 1, 0); x <= min(ax + 1, gridWidth - 1); ++x) {
+				visible[y * gridWidth + x] = 1;
+			}
+		}
+	}
+
+	// a chunk may be seen from a cell if any cell its bounds overlap is visible from there
+	chunkCount = chunks.size();
+	chunkVisibility.assign(cellCount * chunkCount, 0);
+	for (unsigned int c = 0; c < chunkCount; ++c) {
+		int x0 = (int)floor(chunks[c].boundsMin.x / cellSize) - originX, x1 = (int)floor((chunks[c].boundsMax.x - 0.0001f) / cellSize) - originX;
+		int y0 = (int)floor(chunks[c].boundsMin.y / cellSize) - originY, y1 = (int)floor((chunks[c].boundsMax.y - 0.0001f) / cellSize) - originY;
+		x0 = min(max(x0, 0), gridWidth - 1);
+		y0 = min(max(y0, 0), gridHeight - 1);
+		x1 = min(max(x1, x0), gridWidth - 1);
+		y1 = min(max(y1, y0), gridHeight - 1);
+		for (int from = 0; from < cellCount; ++from) {
+			for (int y = y0; y <= y1 && !chunkVisibility[from * chunkCount + c]; ++y) {
+				for (int x = x0; x <= x1; ++x) {
+					if (cellVisibility[from * cellCount + y * gridWidth + x]) {
+						chunkVisibility[from * chunkCount + c] = 1;
+						break;
+					}
+				}
+			}
+		}
+	}
+	// the occluders are only needed while building
+	quads.clear();
+	quadNormals.clear();
+	cellQuads.clear();
+	openX.clear();
+	openY.clear();
+}
+
+bool PVS::isBuilt() const {
+	return gridWidth > 0 && !chunkVisibility.empty();
+}
+
+int PVS::cellAt(glm::vec3 p) const {
+	int x = (int)floor(p.x / cellSize) - originX;
+	int y = (int)floor(p.y / cellSize) - originY;
+	if (x < 0 || y < 0 || x >= gridWidth || y >= gridHeight) {
+		return -1;
+	}
+	return y * gridWidth + x;
+}
+
+const unsigned char *PVS::visibleChunks(int cell) const {
+	if (!isBuilt() || cell < 0 || cell >= gridWidth * gridHeight) {
+		return NULL;
+	}
+	return &chunkVisibility[cell * chunkCount];
+}
+
+bool PVS::isCellVisible(int from, int to) const {
+	int cellCount = gridWidth * gridHeight;
+	if (!isBuilt() || from < 0 || to < 0 || from >= cellCount || to >= cellCount) {
+		return true;
+	}
+	return cellVisibility[from * gridWidth * gridHeight + to] != 0;
+}
+
+void PVS::floodQuadrant(int x0, int y0, int stepX, int stepY, unsigned char *visible) {
+	// cells are visited away from (x0, y0), so the two cells a staircase can come from are done first
+	visible[y0 * gridWidth + x0] = 1;
+	for (int y = y0; y >= 0 && y < gridHeight; y += stepY) {
+		for (int x = x0; x >= 0 && x < gridWidth; x += stepX) {
+			int cell = y * gridWidth + x;
+			if (x != x0) {
+				int from = cell - stepX;
+				// the face between two cells is stored with the one at the lower coordinate
+				if (visible[from] && openX[min(from, cell)]) {
+					visible[cell] = 1;
+				}
+			}
+			if (y != y0) {
+				int from = cell - stepY * gridWidth;
+				if (visible[from] && openY[min(from, cell)]) {
+					visible[cell] = 1;
+				}
+			}
+		}
+	}
+}
+
+bool PVS::isFaceCovered(int a, int b, int axis, float plane, glm::vec2 faceMin, glm::vec2 faceMax) const {
+	const float epsilon = 0.001f;
+	// the quads of both cells lying in the plane, the corners of their bounds split the face into
+	// rectangles that are each either covered by one of them or open
+	vector<unsigned int> inPlane;
+	vector<float> us, vs;
+	us.push_back(faceMin.x);
+	us.push_back(faceMax.x);
+	vs.push_back(faceMin.y);
+	vs.push_back(faceMax.y);
+	const vector<unsigned int> *candidates[2] = { &cellQuads[a], &cellQuads[b] };
+	for (int c = 0; c < 2; ++c) {
+		for (unsigned int i = 0; i < candidates[c]->size(); ++i) {
+			unsigned int q = (*candidates[c])[i];
+			const glm::vec3 *p = &quads[q * 4];
+			if (fabs(quadNormals[q][axis]) < 0.999f || fabs(p[0][axis] - plane) > epsilon) {
+				continue;
+			}
+			inPlane.push_back(q);
+			for (int j = 0; j < 4; ++j) {
+				float u = p[j][1 - axis], v = p[j].z;
+				if (u > faceMin.x && u < faceMax.x) {
+					us.push_back(u);
+				}
+				if (v > faceMin.y && v < faceMax.y) {
+					vs.push_back(v);
+				}
+			}
+		}
+	}
+	if (inPlane.empty()) {
+		return false;
+	}
+	sort(us.begin(), us.end());
+	sort(vs.begin(), vs.end());
+	for (unsigned int i = 0; i + 1 < us.size(); ++i) {
+		if (us[i + 1] - us[i] < epsilon) {
+			continue;
+		}
+		for (unsigned int j = 0; j + 1 < vs.size(); ++j) {
+			if (vs[j + 1] - vs[j] < epsilon) {
+				continue;
+			}
+			glm::vec3 p;
+			p[axis] = plane;
+			p[1 - axis] = (us[i] + us[i + 1]) * 0.5f;
+			p.z = (vs[j] + vs[j + 1]) * 0.5f;
+			bool covered = false;
+			for (unsigned int k = 0; k < inPlane.size() && !covered; ++k) {
+				covered = isPointOnQuad(inPlane[k], p);
+			}
+			if (!covered) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool PVS::isPointOnQuad(unsigned int q, glm::vec3 p) const {
+	const glm::vec3 *corners = &quads[q * 4];
+	glm::vec3 n = quadNormals[q];
+	for (int i = 0; i < 4; ++i) {
+		if (glm::dot(glm::cross(corners[(i + 1) % 4] - corners[i], p - corners[i]), n) < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
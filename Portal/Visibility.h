@@ -0,0 +1,56 @@
+#ifndef VISIBILITY_H
+#define VISIBILITY_H
+
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+
+#include <vector>
+
+using namespace std;
+
+// maps with more grid cells than this skip the precomputation and rely on frustum culling alone
+#define PVS_MAX_CELLS 4096
+
+struct MapChunk;
+
+// Potentially visible sets of a map. The map is partitioned into the same XY grid cells as its
+// chunks. A face between two neighbouring cells is closed when the map quads lying in it cover it
+// from the floor to the ceiling of the map. A line of sight crosses the cells between its ends in a
+// staircase that only ever steps towards the other end, so a cell may be seen from another if such a
+// staircase of open faces connects them. This keeps every cell that can be seen, at the cost of some
+// that can't. For every cell the set of chunks that may be seen from it is kept.
+class PVS {
+public:
+	PVS();
+
+	// builds the cell to cell and cell to chunk visibility of a map mesh made of quads
+	void build(const vector<Vertex> &vertices, const vector<unsigned int> &indices, const vector<MapChunk> &chunks, float size);
+	bool isBuilt() const;
+	// the cell containing a point, -1 outside the map
+	int cellAt(glm::vec3 p) const;
+	// one byte per chunk, non-zero if the chunk may be seen from the cell; NULL if unknown
+	const unsigned char *visibleChunks(int cell) const;
+	bool isCellVisible(int from, int to) const;
+
+private:
+	int originX, originY, gridWidth, gridHeight;
+	float cellSize, minZ, maxZ;
+	unsigned int chunkCount;
+	vector<glm::vec3> quads;				// four corners per quad
+	vector<glm::vec3> quadNormals;
+	vector<vector<unsigned int>> cellQuads;	// quads overlapping each cell
+	vector<unsigned char> cellVisibility;	// cell x cell
+	vector<unsigned char> chunkVisibility;	// cell x chunk
+	// per cell, whether the face to the cell at x + 1 and the one to the cell at y + 1 are open
+	vector<unsigned char> openX, openY;
+
+	// whether the quads of cells a and b that lie in the plane coordinate axis = plane cover the rectangle
+	// from faceMin to faceMax in it, both given in the other horizontal axis and z
+	bool isFaceCovered(int a, int b, int axis, float plane, glm::vec2 faceMin, glm::vec2 faceMax) const;
+	bool isPointOnQuad(unsigned int q, glm::vec3 p) const;
+	// marks the cells a staircase of open faces leads to from cell (x, y), stepping by stepX and stepY
+	void floodQuadrant(int x, int y, int stepX, int stepY, unsigned char *visible);
+};
+
+#endif
@@ -5,18 +5,52 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <thread>
+#include <chrono>
 
 #include "Shader.h"
 #include "Camera.h"
 #include "Model.h"
 #include "Physics.h"
-#include "Portal.h"
+#include "PortalManager.h"
+#include "MultiView.h"
+#include "PortalView.h"
+#include "GpuTimer.h"
+#include "Frustum.h"
+#include "PlayRecording.h"
+#include "AllocationCounter.h"
+#include "RigidBodies.h"
+#include "RigidBodyRenderer.h"
+#include "InstancedModels.h"
+#include "Overlay.h"
+#include "SceneTarget.h"
+#include "JobSystem.h"
+#include "RenderState.h"
+#include "RenderCommands.h"
+#include "RenderThread.h"
+#include "LevelManager.h"
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void processInput(GLFWwindow *window);
+void simulate(void *data, int begin, int end);
+void startNextLevel();
 void glInitialize();
+int portalClipPlanes(int id, const glm::mat4 &insideView, glm::vec3 exitPos, glm::vec3 exitN, glm::vec4 *planes);
+const glm::mat4 &cachedProjection(float zoom, int screenWidth, int screenHeight);
+
+// the programs drawing the scene for one view: the regular one, a depth-only one, the overdraw visualisation and the props
+struct SceneShaders {
+	Shader *color;
+	Shader *depth;
+	Shader *overdraw;
+	Shader *box;
+	Shader *props;
+};
+void drawSceneView(RenderCommandList &commands, Model &scene, const SceneShaders &shaders, const glm::mat4 &projection, const glm::mat4 &view, glm::vec3 eye, const glm::vec4 *clipPlane, const Frustum &frustum, int cell);
 
 // settings
 const unsigned int SCR_WIDTH = 1366;
@@ -39,12 +73,85 @@ float lastFrame = 0.0f;
 glm::vec3 speed = glm::vec3(0.0f, 0.0f, 0.0f);
 glm::vec3 keyboardSpeed = glm::vec3(0.0f, 0.0f, 0.0f);
 bool isJumping = false;
-Physics physics("Map4.txt", "Win4.txt", glm::vec3(0.0f, 0.0f, 1.0f));
+bool isWin = false;
+bool passedPortal = false;	// the last tick carried the player through a portal
+Physics physics;
 glm::vec3 playerSize = glm::vec3(0.0f, 0.0f, 2.0f);
 glm::vec3 playerPos, cameraPos;
+glm::vec3 lastEye = camera.Position;	// the eye after the previous tick, where this tick's portal sweep starts
+
+// Levels: the next one is loaded in the background and swapped in once the current one is passed
+LevelManager levels;
+float levelStartTime = -100.0f;
+const float LEVEL_HINT_TIME = 2.0f;	// seconds the hint stays after the next level starts
 
 // Portal
-Portal portal;
+PortalManager portals;
+int activePair = 0;		// the pair the mouse buttons place, picked with the number keys
+bool portalMeshPending[PORTAL_MAX_PAIRS * 2] = { false };	// placed since the last frame was recorded
+
+// Threads: the next tick is simulated on the job system while the last one is recorded,
+// the render thread replays the frame recorded before
+JobSystem jobs;
+RenderThread renderThread;
+RenderState renderStates[2];
+int drawnState = 0;		// the render state the render loop draws, the simulation fills the other
+
+// Props, F9 drops a box in front of the player and F10 a hundred of them
+RigidBodies bodies(physics, &portals, &jobs);
+RigidBodyRenderer bodyRenderer;
+// P stands a statue where the player looks, all of them are drawn with one instanced draw per mesh
+InstancedModels propRenderer;
+vector<ModelInstance> props;
+bool propsChanged = false;	// props changed since the last upload
+unsigned int propsVersion = 0;	// incremented with every upload of the props
+int propModel = 0;
+
+// Rendering
+enum PortalRenderMode {
+	PORTAL_STENCIL,		// every portal view redraws the scene under its stencil mask
+	PORTAL_MULTIVIEW,	// the main view and all portal views are drawn with instanced draws
+	PORTAL_TEXTURE		// portal views are rendered offscreen at reduced size and composited
+};
+PortalRenderMode portalRenderMode = PORTAL_STENCIL;	// F1 cycles the modes
+float portalViewScale = 0.75f;	// F2 cycles the quality of offscreen portal views
+MultiView multiView;
+// portal views rendered per frame at most, the nearest visible portals get them
+const int PORTAL_VIEW_BUDGET = 4;
+PortalView portalViews[PORTAL_VIEW_BUDGET];
+bool depthPrePass = false;	// F3: lay down depth before shading each view
+bool frontToBack = false;	// F4: draw the map chunks ordered front to back
+bool overdrawView = false;	// F5: show how many fragments are shaded per pixel
+bool frustumCulling = true;	// F6: skip map chunks outside of each view
+bool pvsCulling = true;		// F7: skip map chunks that can't be seen from the cell of each view
+int drawnChunks = 0;
+GpuTimer sceneTimer, portalTimer;
+// F12: the scene is rendered at a fraction of the window resolution that holds the GPU time of a frame
+// below most of the refresh period, and stretched over the window
+SceneTarget sceneTarget;
+bool dynamicResolution = true;
+bool captureCommands = false;	// F11 writes the commands of the next frame to render_commands.txt
+// crosshair, hint and debug text, rebuilt every frame and drawn in one call
+OverlayBatch overlay;
+OverlayRenderer overlayRenderer;
+bool showStats = false;		// H: frame statistics and a graph of the last frame times
+const int FRAME_HISTORY = 128;
+float frameTimes[FRAME_HISTORY];
+int frameTimeIndex = 0;
+// L: sleep after each frame is presented until just enough of the refresh period is left to make the next,
+// so its input is sampled as late as possible; off, the game runs up to a frame ahead of the screen
+bool frameLimiter = false;
+float refreshPeriod = 1000.0f / 60.0f;		// ms
+const float FRAME_LIMITER_MARGIN = 2.0f;	// ms left for the frame times to vary
+float recordMilliseconds = 0.0f;			// of the last frame, from sampling its input to submitting it
+// the late latch turns a frame by at most this much, degrees; frames that will be latched are culled with a
+// field of view widened by it on every side, so nothing culled can turn into view, and a larger turn of the
+// mouse while recording leaves the frame as it was recorded
+const float LATCH_GUARD_BAND = 5.0f;
+glm::mat4 guardBandProjection;	// widened projection for culling, rebuilt with the projection
+
+// F8 records the play session for the benchmarks
+PlayRecording playRecording;
 
 int main() {
 	glInitialize();
@@ -58,12 +165,22 @@ int main() {
 		return -1;
 	}
 	glfwMakeContextCurrent(window);
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetMouseButtonCallback(window, mouse_button_callback);
+	glfwSetKeyCallback(window, key_callback);
 
 	// tell GLFW to capture our mouse
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	// and to report its motion unaccelerated where the platform can, GLFW 3.3 on
+#ifdef GLFW_RAW_MOUSE_MOTION
+	if (glfwRawMouseMotionSupported()) {
+		glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
+	}
+#endif
+	const GLFWvidmode *videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+	if (videoMode != NULL && videoMode->refreshRate > 0) {
+		refreshPeriod = 1000.0f / videoMode->refreshRate;
+	}
 
 	// glad: load all OpenGL function pointers
 	// ---------------------------------------
@@ -76,206 +193,415 @@ int main() {
 	// -----------------------------
 	glEnable(GL_DEPTH_TEST);
 
-	Shader shader("shader.vs", "shader.fs");
-	Shader shaderCross("shader_cross.vs", "shader_cross.fs");
-	Shader shaderPortal("shader_portal.vs", "shader_portal.fs");
-	Shader shaderPortalInside("shader_portal_inside.vs", "shader_portal_inside.fs");
-	Shader shaderPortalMask("shader_portal_mask.vs", "shader_portal_mask.fs");
-	Shader shaderHint("shader_hint.vs", "shader_hint.fs");
-
-	Model scene("Map4.txt");
-	Model crossHairs("Map_cross.txt");
+	// the map and portal programs are permutations of shader_scene, the map geometry is in world space
+	Shader shader("shader_scene.vs", "shader_scene.fs", nullptr, "TEXTURE_ARRAY");
+	Shader shaderPortal("shader_scene.vs", "shader_scene.fs", nullptr, "PORTAL_VIEW ALPHA_MIN=0.1 ALPHA_MAX=0.95");
+	Shader shaderPortalInside("shader_scene.vs", "shader_scene.fs", nullptr, "TEXTURE_ARRAY CLIP_PLANE");
+	Shader shaderPortalMask("shader_scene.vs", "shader_scene.fs", nullptr, "ALPHA_MIN=1.0");
+	Shader shaderMultiView("shader_multiview.vs", "shader_scene.fs", nullptr, "TEXTURE_ARRAY");
+	Shader shaderDepth("shader_scene.vs", "shader_depth.fs");
+	Shader shaderDepthInside("shader_scene.vs", "shader_depth.fs", nullptr, "CLIP_PLANE");
+	Shader shaderOverdraw("shader_scene.vs", "shader_overdraw.fs");
+	Shader shaderOverdrawInside("shader_scene.vs", "shader_overdraw.fs", nullptr, "CLIP_PLANE");
+	Shader shaderBox("shader_box.vs", "shader_box.fs");
+	Shader shaderProps("shader_scene.vs", "shader_scene.fs", nullptr, "INSTANCED");
+	Shader shaderPropsInside("shader_scene.vs", "shader_scene.fs", nullptr, "INSTANCED CLIP_PLANE");
+	Shader shaderOverlay("shader_overlay.vs", "shader_overlay.fs");
+	SceneShaders sceneShaders = { &shader, &shaderDepth, &shaderOverdraw, &shaderBox, &shaderProps };
+	SceneShaders insideShaders = { &shaderPortalInside, &shaderDepthInside, &shaderOverdrawInside, &shaderBox, &shaderPropsInside };
+
+	// the levels are played in the order of the list, the first one is loaded right away
+	if (!levels.load("Levels.txt")) {
+		glfwTerminate();
+		return -1;
+	}
+	levels.start(0, physics);
+	camera.Position = lastEye = levels.level().start;
+	Model nanosuit("Objs/nanosuit/nanosuit.blend");
+	propModel = propRenderer.add(nanosuit);
 	
-	portal.initialize();
+	portals.initialize();
+	multiView.initialize();
+	bodyRenderer.initialize();
+	propRenderer.initialize();
+	overlayRenderer.initialize("pass.png");
+	sceneTarget.initialize();
+	// what is left of the period goes to the overlay, the upscale and the variation between frames
+	sceneTarget.targetMilliseconds = refreshPeriod * 0.8f;
+	for (int i = 0; i < PORTAL_VIEW_BUDGET; ++i) {
+		portalViews[i].initialize();
+	}
+	sceneTimer.initialize();
+	portalTimer.initialize();
+	jobs.initialize();
+	renderStates[drawnState].capture(camera, bodies, isWin);
+	float lastTitleUpdate = 0.0f;
 
-	bool isWin = false;
+	// from here on only the render thread touches GL, the viewport follows the window in every frame
+	glfwMakeContextCurrent(NULL);
+	renderThread.start(window);
 
 	// render loop
 	// -----------
 	while (!glfwWindowShouldClose(window)) {
+		if (frameLimiter) {
+			renderThread.waitIdle();
+			float slack = refreshPeriod - recordMilliseconds - renderThread.replayMilliseconds.load() - FRAME_LIMITER_MARGIN;
+			if (slack > 0.0f) {
+				this_thread::sleep_for(chrono::microseconds((long long)(slack * 1000.0f)));
+			}
+		}
+
 		// per-frame time logic
 		// --------------------
 		float currentFrame = glfwGetTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
+		unsigned long long frameStartAllocations = allocationCount();
+		frameTimes[frameTimeIndex] = deltaTime * 1000.0f;
+		frameTimeIndex = (frameTimeIndex + 1) % FRAME_HISTORY;
 
-		// Show hint if win
-		// ------
-		//if (isWin) {
-			
-		//}
-
-		// Update state
-		// ------
-		playerPos = camera.Position - playerSize;
-		if (physics.isWin(playerPos)) {
-			isWin = true;
-		}
-		physics.updateVerticleState(speed, playerPos, deltaTime, isJumping);
-		camera.Position = playerSize + playerPos;
-		
-		cameraPos = camera.Position;
-		bool isPass = false;
-		glm::vec3 cameraFront = camera.Front;
-		float rotateAngle = portal.passPortal(cameraPos, speed, keyboardSpeed, cameraFront, deltaTime, isPass);
-		camera.ProcessMouseMovement(rotateAngle * 10.0f * 180.0f / 3.1416f, 0.0f);
-		camera.Position = cameraPos;
-
-		// input
+		// input, GLFW is only polled from this thread and never while the simulation runs
 		// -----
+		glfwPollEvents();
+		camera.ApplyMouseMovement();
+		double inputTime = glfwGetTime();
 		keyboardSpeed = glm::vec3(0.0f, 0.0f, 0.0f);
-		if (!isPass)
+		if (!passedPortal)
 			processInput(window);
+		// a passed level is swapped for the next one between two ticks, once that is loaded and uploaded
+		if (isWin && levels.nextReady()) {
+			startNextLevel();
+			levelStartTime = currentFrame;
+		}
+		Model &scene = *levels.scene;
+
+		// simulate the next tick on the job system while the state of the last one is drawn
+		// ------
+		JobCounter simulation;
+		jobs.run(simulate, NULL, 0, 1, simulation);
+		const RenderState &state = renderStates[drawnState];
 
-		// render
+		// render: recorded into a command list the render thread replays while the next frame is prepared
 		// ------
-		glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		RenderCommandList &commands = renderThread.beginFrame();
+		drawnChunks = commands.drawnChunks;
+		int screenWidth, screenHeight;
+		glfwGetFramebufferSize(window, &screenWidth, &screenHeight);
+		for (int i = 0; i < portals.portalCount(); ++i) {
+			if (portalMeshPending[i]) {
+				commands.buildPortalMesh(&portals, i);
+				portalMeshPending[i] = false;
+			}
+		}
+		levels.update(commands);
+		commands.uploadBoxes(&bodyRenderer, state.boxes);
+		if (propsChanged) {
+			commands.uploadModelInstances(&propRenderer, props);
+			propsChanged = false;
+			++propsVersion;
+		}
+		// the scene and the portals are drawn at renderWidth by renderHeight, into the scene target if it is on
+		int renderWidth = screenWidth, renderHeight = screenHeight;
+		unsigned int sceneFramebuffer = 0;
+		if (dynamicResolution) {
+			// the elapsed time of the passes only counts the GPU at work, time it waits on a render thread that
+			// is still recording or on a slow CPU doesn't shrink the resolution
+			sceneTarget.update(screenWidth, screenHeight, sceneTimer.milliseconds.load() + portalTimer.milliseconds.load(), renderWidth, renderHeight);
+			sceneFramebuffer = sceneTarget.FBO;
+			commands.beginScene(&sceneTarget, renderWidth, renderHeight, screenWidth, screenHeight);
+		}
+		else {
+			commands.viewport(0, 0, screenWidth, screenHeight);
+		}
+		glm::vec4 clearColor = overdrawView ? glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) : glm::vec4(0.05f, 0.05f, 0.05f, 1.0f);
+		commands.clear(CLEAR_COLOR | CLEAR_DEPTH | CLEAR_STENCIL, clearColor);
 
 		// view/projection transformations
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-		glm::mat4 view = camera.GetViewMatrix();
-		glm::mat4 model;
-
-		// render the model
-		/*
-		shader.use();
-		shader.setMat4("projection", projection);
-		shader.setMat4("view", view);
-		shader.setMat4("model", model);
-		scene.Draw(shader);*/
+		const glm::mat4 &projection = cachedProjection(state.zoom, screenWidth, screenHeight);
+		glm::mat4 view = state.view;
+		// composited portal views are never latched, the other modes cull for the turn the latch may add
+		const glm::mat4 &cullProjection = (portalRenderMode != PORTAL_TEXTURE) ? guardBandProjection : projection;
 
 		// -----------------------------------------
 
-		glClearStencil(0);
-		glClear(GL_STENCIL_BUFFER_BIT);
-
-		glStencilFunc(GL_ALWAYS, 1, 0xFF);
-		glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-		glEnable(GL_STENCIL_TEST);
-
-		glDepthMask(GL_FALSE);
-		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-
-		shaderPortalMask.use();
-		shaderPortalMask.setMat4("projection", projection);
-		shaderPortalMask.setMat4("view", view);
-		shaderPortalMask.setMat4("model", model);
-		portal.Draw(shaderPortalMask);
+		// remote views through the nearest portals in view, so the frame cost follows the visible portals
+		Frustum mainFrustum;
+		mainFrustum.extract(cullProjection * view);
+		int visiblePortals[PORTAL_VIEW_BUDGET];
+		int visibleCount = portals.visiblePortals(mainFrustum, state.eye, PORTAL_VIEW_BUDGET, visiblePortals);
+		glm::mat4 insideViews[PORTAL_VIEW_BUDGET];
+		glm::vec3 exitPos[PORTAL_VIEW_BUDGET], exitN[PORTAL_VIEW_BUDGET];
+		for (int v = 0; v < visibleCount; ++v) {
+			int id = visiblePortals[v];
+			insideViews[v] = portals.viewThrough(id, view);
+			exitPos[v] = portals.position[portals.exit(id)];
+			exitN[v] = portals.normal[portals.exit(id)];
+		}
 
-		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-		glDepthMask(GL_TRUE);
+		// render the portal views offscreen, the portals are composited over the main view afterwards
+		bool insideTexture[PORTAL_VIEW_BUDGET] = { false };
+		if (portalRenderMode == PORTAL_TEXTURE) {
+			// the cached views are redrawn when a portal is placed, a box moves or the props change;
+			// each version only grows, so their sum changes with any of them
+			unsigned int sceneVersion = portals.version + state.bodiesVersion + propsVersion;
+			commands.beginTimer(&portalTimer);
+			for (int v = 0; v < visibleCount; ++v) {
+				glm::vec3 corners[4];
+				portals.getCorners(visiblePortals[v], corners);
+				portalViews[v].qualityScale = portalViewScale;
+				insideTexture[v] = portalViews[v].updateFootprint(projection * view, corners, 4, renderWidth, renderHeight);
+				if (!insideTexture[v] || !portalViews[v].needsRender(insideViews[v], sceneVersion)) {
+					continue;
+				}
+				commands.beginTarget(&portalViews[v]);
+				glm::vec4 clipPlane(exitN[v], -glm::dot(exitN[v], exitPos[v]));
+				glm::mat4 cropProjection = portalViews[v].cropProjection(projection);
+				Frustum frustum;
+				frustum.extract(cropProjection * insideViews[v]);
+				frustum.addPlane(clipPlane);
+				drawSceneView(commands, scene, insideShaders, cropProjection, insideViews[v], glm::vec3(glm::inverse(insideViews[v])[3]), &clipPlane, frustum, scene.pvs.cellAt(exitPos[v] + exitN[v] * 0.5f));
+				commands.endTarget(renderWidth, renderHeight, sceneFramebuffer);
+			}
+			commands.endTimer(&portalTimer);
+		}
 
-		glStencilFunc(GL_EQUAL, 0, 0xFF);
-		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+		commands.beginTimer(&sceneTimer);
+
+		commands.clear(CLEAR_STENCIL, clearColor);
+		commands.setStencil(STENCIL_WRITE);
+		commands.setDepthWrite(false);
+		commands.setColorWrite(false);
+
+		// composited portal views cover the wall themselves and need no mask,
+		// portals without a view this frame show the wall behind them
+		if (portalRenderMode != PORTAL_TEXTURE) {
+			commands.useProgram(&shaderPortalMask);
+			commands.setMat4("projection", projection);
+			commands.setMat4("view", view, true);
+			for (int v = 0; v < visibleCount; ++v) {
+				commands.drawPortal(&portals, visiblePortals[v]);
+			}
+		}
 
-		shader.use();
-		shader.setMat4("projection", projection);
-		shader.setMat4("view", view);
-		shader.setMat4("model", model);
-		scene.Draw(shader);
+		commands.setColorWrite(true);
+		commands.setDepthWrite(true);
+		commands.setStencil(STENCIL_OUTSIDE);
+
+		int insideViewCount = 0;
+		if (portalRenderMode == PORTAL_MULTIVIEW) {
+			// view 0 is the main camera, the remote views follow it and are drawn together below
+			multiView.clear();
+			multiView.addView(projection * view, NULL, 0);
+			for (int v = 0; v < visibleCount && v < MAX_VIEWS - 1; ++v) {
+				glm::vec4 planes[VIEW_CLIP_PLANES];
+				int planeCount = portalClipPlanes(visiblePortals[v], insideViews[v], exitPos[v], exitN[v], planes);
+				multiView.addView(projection * insideViews[v], planes, planeCount);
+				++insideViewCount;
+			}
+			commands.useProgram(&shaderMultiView);
+			commands.uploadViews(multiView, true);
+			commands.setInt("viewBase", 0);
+			commands.drawInstanced(&scene, 1);
+			// the props only show in the main view here, the portal views draw the map alone
+			commands.useProgram(&shaderBox);
+			commands.setMat4("projection", projection);
+			commands.setMat4("view", view, true);
+			commands.drawBoxes(&bodyRenderer);
+			if (!props.empty()) {
+				commands.useProgram(&shaderProps);
+				commands.setMat4("projection", projection);
+				commands.setMat4("view", view, true);
+				commands.drawModelInstances(&propRenderer);
+			}
+		}
+		else {
+			drawSceneView(commands, scene, sceneShaders, projection, view, state.eye, NULL, mainFrustum, scene.pvs.cellAt(state.eye));
+		}
 
-		glDisable(GL_STENCIL_TEST);
+		commands.setStencil(STENCIL_OFF);
+		commands.endTimer(&sceneTimer);
 
 		// ----------------------------------------
 
-		// draw cross
-		shaderCross.use();
-		crossHairs.Draw(shaderCross);
-
 		// draw portal
-		shaderPortal.use();
-		shaderPortal.setMat4("projection", projection);
-		shaderPortal.setMat4("view", view);
-		shaderPortal.setMat4("model", model);
-		portal.Draw(shaderPortal);
-
-		// draw scene inside portal
-		if (portal.bluePortalExist && portal.orangePortalExist) {
-			glm::vec3 Front = camera.Front;
-			glm::vec3 Up = camera.Up;
-			glm::vec3 pos = camera.Position;
-
-			for (int i = 0; i < 2; ++i) {
-				glm::vec3 PortalN, PortalPos, PortalUp, PortalRight, PortalN_, PortalPos_, PortalUp_, PortalRight_;
-				if (i == 0) {
-					PortalN = portal.bluePortalN;
-					PortalPos = portal.bluePortalPos;
-					PortalN_ = portal.orangePortalN;
-					PortalPos_ = portal.orangePortalPos;
+		commands.useProgram(&shaderPortal);
+		commands.setMat4("projection", projection);
+		commands.setMat4("view", view, true);
+		if (portalRenderMode == PORTAL_TEXTURE && visibleCount > 0) {
+			commands.setVec2("screenSize", glm::vec2((float)renderWidth, (float)renderHeight));
+			commands.setInt("texture_view", 1);
+			for (int i = 0; i < portals.portalCount(); ++i) {
+				if (!portals.placed[i]) {
+					continue;
+				}
+				int v = 0;
+				while (v < visibleCount && visiblePortals[v] != i) {
+					++v;
 				}
-				else {
-					PortalN_ = portal.bluePortalN;
-					PortalPos_ = portal.bluePortalPos;
-					PortalN = portal.orangePortalN;
-					PortalPos = portal.orangePortalPos;
+				bool useView = (v < visibleCount && insideTexture[v]);
+				commands.setBool("useView", useView);
+				if (useView) {
+					commands.setVec4("viewRect", portalViews[v].screenRect);
+					commands.setVec2("viewScale", portalViews[v].textureScale());
+					commands.bindTexture(1, portalViews[v].colorTexture);
 				}
+				commands.drawPortal(&portals, i);
+			}
+		}
+		else {
+			commands.setBool("useView", false);
+			commands.drawPortals(&portals);
+		}
 
-				PortalUp = glm::vec3(0.0f, 0.0f, 1.0f);
-				PortalUp_ = glm::vec3(0.0f, 0.0f, 1.0f);
-				PortalRight = glm::normalize(glm::cross(PortalUp, PortalN));
-				PortalRight_ = glm::normalize(glm::cross(PortalUp_, PortalN_));
+		// draw scene inside portal
+		if (portalRenderMode == PORTAL_MULTIVIEW && insideViewCount > 0) {
+			commands.beginTimer(&portalTimer);
+			// Mask the portals at once, each remote view is confined to its own portal by its clip planes
+			commands.clear(CLEAR_STENCIL, clearColor);
+			commands.setStencil(STENCIL_WRITE);
+			commands.setDepthWrite(false);
+			commands.setColorWrite(false);
+
+			commands.useProgram(&shaderPortalMask);
+			for (int v = 0; v < insideViewCount; ++v) {
+				commands.drawPortal(&portals, visiblePortals[v]);
+			}
 
-				glm::vec3 Front_ = PortalUp_ * glm::dot(Front, PortalUp) - PortalRight_ * glm::dot(Front, PortalRight) - PortalN_ *  glm::dot(Front, PortalN);
-				glm::vec3 Up_ = PortalUp_ * glm::dot(Up, PortalUp) - PortalRight_ * glm::dot(Up, PortalRight) - PortalN_ *  glm::dot(Up, PortalN);
-				Front_ = glm::normalize(Front_);
-				Up_ = glm::normalize(Up_);
-				if (glm::dot(Front, PortalN) == 0) {
-					continue;
-				}
-				float t = glm::dot(PortalPos - pos, PortalN) / glm::dot(Front, PortalN);
-				if (t <= 0.0f) {
-					continue;
-				}
-				glm::vec3 pos1 = pos + Front * t;
-				glm::vec3 pa = pos1 - PortalPos;
-				glm::vec3 pb = PortalUp * glm::dot(pa, PortalUp) - PortalRight * glm::dot(pa, PortalRight);
-				glm::vec3 pos2 = PortalPos_ + pb;
-				glm::vec3 pos_ = pos2 - Front_ * t;
+			commands.setColorWrite(true);
+			commands.setDepthWrite(true);
+			commands.setStencil(STENCIL_INSIDE);
 
-				glm::mat4 insideView = glm::lookAt(pos_, pos_ + Front_ * t, Up_);
-				
+			commands.setClipPlanes(VIEW_CLIP_PLANES);
+			commands.useProgram(&shaderMultiView);
+			commands.setInt("viewBase", 1);
+			commands.drawInstanced(&scene, insideViewCount);
+			commands.setClipPlanes(0);
 
+			commands.setStencil(STENCIL_OFF);
+			commands.endTimer(&portalTimer);
+		}
+		else if (portalRenderMode == PORTAL_STENCIL && visibleCount > 0) {
+			commands.beginTimer(&portalTimer);
+			for (int v = 0; v < visibleCount; ++v) {
 				// Mask
-				
-				glClearStencil(0);
-				glClear(GL_STENCIL_BUFFER_BIT);
-
-				glStencilFunc(GL_ALWAYS, 1, 0xFF);
-				glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-				glEnable(GL_STENCIL_TEST);
-
-				glDepthMask(GL_FALSE);
-				glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-
-				shaderPortalMask.use();
-				shaderPortalMask.setMat4("projection", projection);
-				shaderPortalMask.setMat4("view", view);
-				shaderPortalMask.setMat4("model", model);
-				portal.DrawSingle(shaderPortalMask, i);
-
-				glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-				glDepthMask(GL_TRUE);
-
-				glStencilFunc(GL_EQUAL, 1, 0xFF);
-				glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-				
-				shaderPortalInside.use();
-				shaderPortalInside.setMat4("projection", projection);
-				shaderPortalInside.setMat4("view", insideView);
-				shaderPortalInside.setMat4("model", model);
-				// scene.Draw(shaderPortalInside);
-				scene.DrawExcept(shaderPortalInside, PortalPos_, PortalN_);
-
-				glDisable(GL_STENCIL_TEST);
+				commands.clear(CLEAR_STENCIL, clearColor);
+				commands.setStencil(STENCIL_WRITE);
+				commands.setDepthWrite(false);
+				commands.setColorWrite(false);
+
+				commands.useProgram(&shaderPortalMask);
+				commands.setMat4("projection", projection);
+				commands.setMat4("view", view, true);
+				commands.drawPortal(&portals, visiblePortals[v]);
+
+				commands.setColorWrite(true);
+				commands.setDepthWrite(true);
+				commands.setStencil(STENCIL_INSIDE);
+
+				// the remote view only sees what lies inside the frustum through the exit portal
+				glm::vec4 planes[VIEW_CLIP_PLANES];
+				int planeCount = portalClipPlanes(visiblePortals[v], insideViews[v], exitPos[v], exitN[v], planes);
+				Frustum frustum;
+				frustum.extract(cullProjection * insideViews[v]);
+				for (int j = 0; j < planeCount; ++j) {
+					frustum.addPlane(planes[j]);
+				}
+				// through a portal only what is visible from the cell in front of the exit portal can be seen
+				drawSceneView(commands, scene, insideShaders, projection, insideViews[v], glm::vec3(glm::inverse(insideViews[v])[3]), &planes[0], frustum, scene.pvs.cellAt(exitPos[v] + exitN[v] * 0.5f));
+
+				commands.setStencil(STENCIL_OFF);
 			}
+			commands.endTimer(&portalTimer);
+		}
+		else if (portalRenderMode != PORTAL_TEXTURE) {
+			// no portal pass, the timer only updates in one and would keep the cost of the last, which is gone
+			portalTimer.milliseconds = 0.0f;
+		}
+
+		if (dynamicResolution) {
+			commands.presentScene(&sceneTarget, renderWidth, renderHeight, screenWidth, screenHeight);
 		}
 
-		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
-		// -------------------------------------------------------------------------------
-		glfwSwapBuffers(window);
+		// overlay: crosshair, the hint once the level is passed and the statistics, in screen pixels at full resolution
+		// ------
+		overlay.clear();
+		float centerX = screenWidth * 0.5f, centerY = screenHeight * 0.5f;
+		glm::vec4 crossColor(0.0f, 1.0f, 0.0f, 1.0f);
+		overlay.rect(centerX - 12.0f, centerY - 1.0f, 8.0f, 2.0f, crossColor);
+		overlay.rect(centerX + 4.0f, centerY - 1.0f, 8.0f, 2.0f, crossColor);
+		overlay.rect(centerX - 1.0f, centerY - 12.0f, 2.0f, 8.0f, crossColor);
+		overlay.rect(centerX - 1.0f, centerY + 4.0f, 2.0f, 8.0f, crossColor);
+		if (state.levelPassed || currentFrame - levelStartTime < LEVEL_HINT_TIME) {
+			overlay.image(centerX - 200.0f, screenHeight * 0.25f - 50.0f, 400.0f, 100.0f);
+		}
+		if (showStats) {
+			char stats[128];
+			snprintf(stats, sizeof(stats), "%.1f MS LATENCY %.1f MS GPU %.2f %.2f MS %d/%d CHUNKS %dX%d",
+				deltaTime * 1000.0f, renderThread.latencyMilliseconds.load(), sceneTimer.milliseconds.load(), portalTimer.milliseconds.load(), drawnChunks, (int)scene.chunks.size(),
+				renderWidth, renderHeight);
+			glm::vec4 statsColor(1.0f, 1.0f, 0.0f, 1.0f);
+			overlay.text(10.0f, 10.0f, 2.0f, stats, statsColor);
+			// the bars fill the graph at 33 ms, the line marks 16.7 ms
+			overlay.rect(10.0f, 24.0f, FRAME_HISTORY * 2.0f, 64.0f, glm::vec4(0.15f, 0.15f, 0.15f, 1.0f));
+			overlay.graph(10.0f, 24.0f, FRAME_HISTORY * 2.0f, 64.0f, frameTimes, FRAME_HISTORY, frameTimeIndex, 33.3f, statsColor);
+			overlay.rect(10.0f, 24.0f + 32.0f, FRAME_HISTORY * 2.0f, 1.0f, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+		}
+		// the quads lie in front of everything, without depth writes later quads draw over earlier ones
+		commands.setDepthWrite(false);
+		commands.useProgram(&shaderOverlay);
+		commands.drawOverlay(&overlayRenderer, overlay, screenWidth, screenHeight);
+		commands.setDepthWrite(true);
+
+		// late latch: the mouse moved while the frame was recorded turns its views right before submission.
+		// A tick that carried the player through a portal turned the camera itself, its frame is left as is;
+		// composited portal views are placed on the screen by the recorded view and aren't latched either
+		jobs.wait(simulation);
+		bool latchable = !passedPortal && portalRenderMode != PORTAL_TEXTURE;
 		glfwPollEvents();
+		camera.ApplyMouseMovement();
+		commands.inputTime = inputTime;
+		if (latchable) {
+			glm::mat4 latestView = glm::lookAt(state.eye, state.eye + camera.Front, camera.Up);
+			// angle of the turn from the recorded view to the latest, from the trace of its rotation
+			glm::mat3 turn = glm::mat3(latestView) * glm::transpose(glm::mat3(view));
+			float cosAngle = (turn[0][0] + turn[1][1] + turn[2][2] - 1.0f) * 0.5f;
+			if (cosAngle >= cos(glm::radians(LATCH_GUARD_BAND))) {
+				commands.latchView(view, latestView, projection);
+				commands.inputTime = glfwGetTime();
+			}
+		}
+
+		if (captureCommands) {
+			ofstream capture("render_commands.txt");
+			commands.write(capture);
+			std::cout << "wrote " << commands.size() << " render commands to render_commands.txt" << std::endl;
+			captureCommands = false;
+		}
+		renderThread.submit();
+		recordMilliseconds = (float)((glfwGetTime() - inputTime) * 1000.0);
+		drawnState = 1 - drawnState;
+
+		if (currentFrame - lastTitleUpdate > 0.5f) {
+			char title[160];
+			snprintf(title, sizeof(title), "Portal - %.1f ms frame, %.1f ms latency%s, GPU %.2f ms scene, %.2f ms portals, %d/%d chunks, %d%% resolution",
+				deltaTime * 1000.0f, renderThread.latencyMilliseconds.load(), frameLimiter ? " (limited)" : "",
+				sceneTimer.milliseconds.load(), portalTimer.milliseconds.load(), drawnChunks, (int)scene.chunks.size(),
+				dynamicResolution ? (int)(sceneTarget.scale * 100.0f + 0.5f) : 100);
+			glfwSetWindowTitle(window, title);
+			lastTitleUpdate = currentFrame;
+		}
+
+		// steady-state frames shouldn't touch the heap, debug builds report the ones that do
+		if (isCountingAllocations() && currentFrame > 5.0f) {
+			unsigned long long frameAllocations = allocationCount() - frameStartAllocations;
+			if (frameAllocations > 0) {
+				std::cout << "frame made " << frameAllocations << " heap allocations" << std::endl;
+			}
+		}
 	}
+	renderThread.stop();
+	glfwMakeContextCurrent(window);
 
 	// optional: de-allocate all resources once they've outlived their purpose:
 	// ------------------------------------------------------------------------
@@ -294,28 +620,28 @@ void processInput(GLFWwindow *window) {
 
 	keyboardSpeed = glm::vec3(0.0f, 0.0f, 0.0f);
 	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-		glm::vec3 movement = glm::normalize(camera.Front - camera.WorldUp * (camera.Front * camera.WorldUp)) * camera.MovementSpeed * deltaTime * 35.0f;
+		glm::vec3 movement = camera.Heading * camera.MovementSpeed * deltaTime * 35.0f;
 		if (physics.isHorizontalAvailable(camera.Position, movement)) {
 			camera.ProcessKeyboard(FORWARD, deltaTime);
 			keyboardSpeed += movement;
 		}
 	}
 	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-		glm::vec3 movement = glm::normalize(camera.Front - camera.WorldUp * (camera.Front * camera.WorldUp)) * camera.MovementSpeed * deltaTime * -35.0f;
+		glm::vec3 movement = camera.Heading * camera.MovementSpeed * deltaTime * -35.0f;
 		if (physics.isHorizontalAvailable(camera.Position, movement)) {
 			camera.ProcessKeyboard(BACKWARD, deltaTime);
 			keyboardSpeed += movement;
 		}
 	}
 	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-		glm::vec3 movement = glm::normalize(camera.Right - camera.WorldUp * (camera.Right * camera.WorldUp)) * camera.MovementSpeed * deltaTime * -35.0f;
+		glm::vec3 movement = camera.Right * camera.MovementSpeed * deltaTime * -35.0f;
 		if (physics.isHorizontalAvailable(camera.Position, movement)) {
 			camera.ProcessKeyboard(LEFT, deltaTime);
 			keyboardSpeed += movement;
 		}
 	}
 	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-		glm::vec3 movement = glm::normalize(camera.Right - camera.WorldUp * (camera.Right * camera.WorldUp)) * camera.MovementSpeed * deltaTime * 35.0f;
+		glm::vec3 movement = camera.Right * camera.MovementSpeed * deltaTime * 35.0f;
 		if (physics.isHorizontalAvailable(camera.Position, movement)) {
 			camera.ProcessKeyboard(RIGHT, deltaTime);
 			keyboardSpeed += movement;
@@ -328,6 +654,66 @@ void processInput(GLFWwindow *window) {
 	}
 }
 
+// one tick of the game state: the player, portal crossings and the props. Runs as a job next to the GL
+// submission of the previous tick and leaves what is drawn of it in the render state not being drawn
+void simulate(void *, int, int) {
+	playerPos = camera.Position - playerSize;
+	if (playRecording.isRecording()) {
+		PlaySample sample = { playerPos, speed, keyboardSpeed, camera.Front, camera.Yaw, camera.Pitch, deltaTime };
+		playRecording.recordFrame(sample);
+	}
+	if (physics.isWin(playerPos)) {
+		isWin = true;
+	}
+	physics.updateVerticleState(speed, playerPos, deltaTime, isJumping);
+	camera.Position = playerSize + playerPos;
+	// horizontal momentum, e.g. carried out of a portal, lasts until the player lands or hits a wall
+	glm::vec3 drift = glm::vec3(speed.x, speed.y, 0.0f) * deltaTime;
+	if (drift.x != 0.0f || drift.y != 0.0f) {
+		if (physics.isHorizontalAvailable(camera.Position, drift))
+			camera.Position += drift;
+		else
+			speed.x = speed.y = 0.0f;
+	}
+
+	// sweep the whole motion of the tick, walking included, so no speed skips a portal;
+	// speed points down along z, the portal transforms work on the world velocity
+	cameraPos = camera.Position;
+	glm::vec3 velocity(speed.x, speed.y, -speed.z);
+	glm::vec3 cameraFront = camera.Front, cameraUp = camera.Up;
+	float timeOfImpact;
+	passedPortal = portals.passPortal(lastEye, cameraPos, velocity, cameraFront, playerSize.z, timeOfImpact, &cameraUp) >= 0;
+	if (passedPortal) {
+		speed = glm::vec3(velocity.x, velocity.y, -velocity.z);
+		isJumping = true;
+		// the up vector keeps the heading of a look straight into or out of a floor or ceiling portal
+		camera.SetFront(cameraFront, cameraUp);
+		camera.Position = cameraPos;
+	}
+	lastEye = camera.Position;
+
+	bodies.update(deltaTime);
+
+	renderStates[1 - drawnState].capture(camera, bodies, isWin);
+}
+
+// makes the loaded next level the one played: its physics replace the old, the portals and props of the old
+// one are removed and the player starts over. Runs between ticks, the render thread releases the old map
+void startNextLevel() {
+	levels.advance(physics);
+	portals.removeAll();
+	portals.cutOpenings(physics);
+	bodies.clear();
+	props.clear();
+	propsChanged = true;
+	camera.Position = lastEye = levels.level().start;
+	speed = glm::vec3(0.0f, 0.0f, 0.0f);
+	isJumping = false;
+	isWin = false;
+	passedPortal = false;
+	renderStates[drawnState].capture(camera, bodies, isWin);
+}
+
 // glfw: whenever the mouse moves, this callback is called
 // -------------------------------------------------------
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -343,30 +729,118 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 	lastX = xpos;
 	lastY = ypos;
 
-	camera.ProcessMouseMovement(xoffset, yoffset);
+	// the events of a poll turn the camera once, after it
+	camera.QueueMouseMovement(xoffset, yoffset);
 }
 
 // glfw: whenever the mouse clicked, this callback is called
 // -------------------------------------------------------
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
 	if (action == GLFW_PRESS) {
-		int whichButton = (button == GLFW_MOUSE_BUTTON_RIGHT);
+		// aim with all the mouse moved so far
+		camera.ApplyMouseMovement();
+		int whichPortal = activePair * 2 + (button == GLFW_MOUSE_BUTTON_RIGHT);
 		bool isIntersected;
 		glm::vec3 pos, n, up;
 		isIntersected = physics.isIntersected(camera.Position, camera.Front, pos, n, up);
-		// portal.setPortal(whichButton, glm::vec3(15.0f, 9.0f, 7.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+		// portals.setPortal(whichPortal, glm::vec3(15.0f, 9.0f, 7.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 		if (isIntersected) {
-			portal.setPortal(whichButton, pos, n, up);
+			// the render thread builds the mesh with the next frame
+			portals.placePortal(whichPortal, pos, n, up);
+			portalMeshPending[whichPortal] = true;
+			portals.cutOpenings(physics);
+			playRecording.recordPortal(whichPortal, pos, n, up);
 		}
 	}
 }
 
-// glfw: whenever the window size changed (by OS or user resize) this callback function executes
-// ---------------------------------------------------------------------------------------------
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-	// make sure the viewport matches the new window dimensions; note that width and 
-	// height will be significantly larger than specified on retina displays.
-	glViewport(0, 0, width, height);
+// glfw: whenever a key is pressed, this callback is called
+// -------------------------------------------------------
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	if (action != GLFW_PRESS) {
+		return;
+	}
+	camera.ApplyMouseMovement();
+	if (key == GLFW_KEY_F1) {
+		const char *names[] = { "stencil", "multi-view", "texture" };
+		portalRenderMode = (PortalRenderMode)((portalRenderMode + 1) % 3);
+		std::cout << "portal render mode: " << names[portalRenderMode] << std::endl;
+	}
+	if (key == GLFW_KEY_F2) {
+		portalViewScale = (portalViewScale <= 0.25f) ? 1.0f : portalViewScale - 0.25f;
+		std::cout << "portal view scale: " << portalViewScale << std::endl;
+	}
+	if (key == GLFW_KEY_F3) {
+		depthPrePass = !depthPrePass;
+		std::cout << "depth pre-pass " << (depthPrePass ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_F4) {
+		frontToBack = !frontToBack;
+		std::cout << "front to back chunk order " << (frontToBack ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_F5) {
+		overdrawView = !overdrawView;
+		std::cout << "overdraw view " << (overdrawView ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_F6) {
+		frustumCulling = !frustumCulling;
+		std::cout << "frustum culling " << (frustumCulling ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_F7) {
+		pvsCulling = !pvsCulling;
+		std::cout << "PVS culling " << (pvsCulling ? "on" : "off") << std::endl;
+	}
+	if (key >= GLFW_KEY_1 && key < GLFW_KEY_1 + portals.pairCount()) {
+		activePair = key - GLFW_KEY_1;
+		std::cout << "placing portal pair " << activePair + 1 << std::endl;
+	}
+	if (key == GLFW_KEY_F9) {
+		bodies.add(camera.Position + camera.Front * 2.0f, glm::vec3(0.4f), camera.Front * 6.0f);
+	}
+	if (key == GLFW_KEY_F10) {
+		for (int i = 0; i < 100; ++i) {
+			glm::vec3 offset((i % 10) - 4.5f, ((i / 10) % 10) - 4.5f, 4.0f);
+			bodies.add(camera.Position + offset * 0.9f, glm::vec3(0.4f), glm::vec3(0.0f));
+		}
+		std::cout << bodies.size() << " boxes" << std::endl;
+	}
+	if (key == GLFW_KEY_P) {
+		glm::vec3 pos, n, up;
+		if (physics.isIntersected(camera.Position, camera.Front, pos, n, up) && n.z > 0.5f) {
+			// the model is y up and 16 units tall, it stands on the floor facing the player
+			float yaw = atan2(camera.Position.y - pos.y, camera.Position.x - pos.x);
+			ModelInstance prop;
+			prop.model = propModel;
+			prop.transform = glm::translate(glm::mat4(), pos) * glm::rotate(glm::mat4(), yaw + glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f))
+				* glm::rotate(glm::mat4(), glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)) * glm::scale(glm::mat4(), glm::vec3(0.12f));
+			props.push_back(prop);
+			propsChanged = true;
+			std::cout << props.size() << " statues" << std::endl;
+		}
+	}
+	if (key == GLFW_KEY_F11) {
+		captureCommands = true;
+	}
+	if (key == GLFW_KEY_H) {
+		showStats = !showStats;
+	}
+	if (key == GLFW_KEY_F12) {
+		dynamicResolution = !dynamicResolution;
+		std::cout << "dynamic resolution " << (dynamicResolution ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_L) {
+		frameLimiter = !frameLimiter;
+		std::cout << "frame limiter " << (frameLimiter ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_F8) {
+		if (playRecording.isRecording()) {
+			playRecording.stop();
+			std::cout << "recording stopped" << std::endl;
+		}
+		else if (playRecording.start("play_recording.txt")) {
+			std::cout << "recording to play_recording.txt" << std::endl;
+		}
+	}
 }
 
 void glInitialize() {
@@ -375,3 +849,104 @@ void glInitialize() {
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 }
+
+// the projection only changes with the zoom and the shape of the window, it is rebuilt then;
+// a minimized window keeps the last one
+glm::mat4 projectionMatrix;
+float projectionZoom = 0.0f, projectionAspect = 0.0f;
+
+const glm::mat4 &cachedProjection(float zoom, int screenWidth, int screenHeight) {
+	float aspect = (screenHeight > 0) ? (float)screenWidth / (float)screenHeight : projectionAspect;
+	if (zoom != projectionZoom || aspect != projectionAspect) {
+		if (aspect <= 0.0f) {
+			aspect = (float)SCR_WIDTH / (float)SCR_HEIGHT;
+		}
+		projectionMatrix = glm::perspective(glm::radians(zoom), aspect, 0.1f, 100.0f);
+		// both half angles grow by the guard band, the horizontal one through the aspect
+		float halfHeight = glm::radians(zoom) * 0.5f + glm::radians(LATCH_GUARD_BAND);
+		float halfWidth = atan(aspect * tan(glm::radians(zoom) * 0.5f)) + glm::radians(LATCH_GUARD_BAND);
+		guardBandProjection = glm::perspective(halfHeight * 2.0f, tan(halfWidth) / tan(halfHeight), 0.1f, 100.0f);
+		projectionZoom = zoom;
+		projectionAspect = aspect;
+	}
+	return projectionMatrix;
+}
+
+// builds the clip planes confining a remote view to the frustum through its exit portal:
+// the exit portal plane itself plus one plane through the virtual eye and each portal edge
+int portalClipPlanes(int id, const glm::mat4 &insideView, glm::vec3 exitPos, glm::vec3 exitN, glm::vec4 *planes) {
+	glm::vec3 corners[4];
+	portals.getCorners(portals.exit(id), corners);
+	glm::vec3 eye = glm::vec3(glm::inverse(insideView)[3]);
+	glm::vec3 center = (corners[0] + corners[2]) * 0.5f;
+	planes[0] = glm::vec4(exitN, -glm::dot(exitN, exitPos));
+	for (int i = 0; i < 4; ++i) {
+		glm::vec3 a = corners[i] - eye;
+		glm::vec3 b = corners[(i + 1) % 4] - eye;
+		glm::vec3 n = glm::normalize(glm::cross(a, b));
+		if (glm::dot(n, center - eye) < 0.0f) {
+			n = -n;
+		}
+		planes[i + 1] = glm::vec4(n, -glm::dot(n, eye));
+	}
+	return 5;
+}
+
+// sets the transformations of a scene program, with clipPlane set GL_CLIP_DISTANCE0 removes everything behind it
+void useSceneShader(RenderCommandList &commands, Shader &shader, const glm::mat4 &projection, const glm::mat4 &view, const glm::vec4 *clipPlane) {
+	commands.useProgram(&shader);
+	commands.setMat4("projection", projection);
+	commands.setMat4("view", view, true);
+	if (clipPlane != NULL) {
+		commands.setVec4("clipPlane", *clipPlane);
+	}
+}
+
+// draws the map chunks of the view with the current settings, countChunks adds them to drawnChunks
+void drawSceneGeometry(RenderCommandList &commands, Model &scene, glm::vec3 eye, const Frustum &frustum, const unsigned char *potentiallyVisible, bool countChunks) {
+	if (frustumCulling || frontToBack || potentiallyVisible != NULL) {
+		commands.drawChunks(&scene, eye, frustumCulling ? &frustum : NULL, potentiallyVisible, frontToBack, countChunks);
+	}
+	else {
+		commands.drawModel(&scene, countChunks);
+	}
+}
+
+// draws the scene for one view under the current stencil state, honouring the
+// depth pre-pass, front to back and overdraw settings
+void drawSceneView(RenderCommandList &commands, Model &scene, const SceneShaders &shaders, const glm::mat4 &projection, const glm::mat4 &view, glm::vec3 eye, const glm::vec4 *clipPlane, const Frustum &frustum, int cell) {
+	const unsigned char *potentiallyVisible = pvsCulling ? scene.pvs.visibleChunks(cell) : NULL;
+	if (clipPlane != NULL) {
+		commands.setClipPlanes(1);
+	}
+	if (depthPrePass) {
+		commands.setColorWrite(false);
+		useSceneShader(commands, *shaders.depth, projection, view, clipPlane);
+		drawSceneGeometry(commands, scene, eye, frustum, potentiallyVisible, false);
+		commands.setColorWrite(true);
+		// only the nearest fragment of each pixel passes now
+		commands.setDepthTest(DEPTH_LESS_EQUAL);
+		commands.setDepthWrite(false);
+	}
+	if (overdrawView) {
+		commands.setAdditiveBlend(true);
+	}
+	Shader &shader = overdrawView ? *shaders.overdraw : *shaders.color;
+	useSceneShader(commands, shader, projection, view, clipPlane);
+	drawSceneGeometry(commands, scene, eye, frustum, potentiallyVisible, true);
+	commands.setAdditiveBlend(false);
+	commands.setDepthTest(DEPTH_LESS);
+	commands.setDepthWrite(true);
+	// the props are seen in every view, through the portals too
+	if (!renderStates[drawnState].boxes.empty()) {
+		useSceneShader(commands, *shaders.box, projection, view, clipPlane);
+		commands.drawBoxes(&bodyRenderer);
+	}
+	if (!props.empty()) {
+		useSceneShader(commands, *shaders.props, projection, view, clipPlane);
+		commands.drawModelInstances(&propRenderer);
+	}
+	if (clipPlane != NULL) {
+		commands.setClipPlanes(0);
+	}
+}
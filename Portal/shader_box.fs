@@ -0,0 +1,10 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Normal;
+
+void main() {
+	vec3 lightDir = normalize(vec3(0.3, 0.5, 1.0));
+	float diffuse = max(dot(normalize(Normal), lightDir), 0.0);
+	FragColor = vec4(vec3(0.75, 0.72, 0.68) * (0.35 + 0.65 * diffuse), 1.0);
+}
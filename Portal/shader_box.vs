@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 3) in vec3 aCenter;
+layout (location = 4) in vec3 aHalfSize;
+
+out vec3 Normal;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec4 clipPlane;
+
+void main() {
+	vec3 worldPos = aCenter + aPos * aHalfSize;
+	Normal = aNormal;
+
+	gl_ClipDistance[0] = dot(vec4(worldPos, 1.0), clipPlane);
+	gl_Position = projection * view * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,28 @@
+#version 330 core
+#define MAX_VIEWS 8
+#define VIEW_CLIP_PLANES 5
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 5) in float aTexLayer;
+
+out vec2 TexCoords;
+flat out float TexLayer;
+
+layout (std140) uniform Views {
+	mat4 viewProjection[MAX_VIEWS];
+	vec4 clipPlanes[MAX_VIEWS * VIEW_CLIP_PLANES];
+};
+
+uniform int viewBase;
+
+void main() {
+	TexCoords = aTexCoords;
+	TexLayer = aTexLayer;
+
+	int view = viewBase + gl_InstanceID;
+	for (int i = 0; i < VIEW_CLIP_PLANES; ++i) {
+		gl_ClipDistance[i] = dot(vec4(aPos, 1.0), clipPlanes[view * VIEW_CLIP_PLANES + i]);
+	}
+	gl_Position = viewProjection[view] * vec4(aPos, 1.0);
+}
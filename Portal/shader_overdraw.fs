@@ -0,0 +1,7 @@
+#version 330 core
+out vec4 FragColor;
+
+// every shaded fragment adds one step, drawn with additive blending
+void main() {
+	FragColor = vec4(0.12, 0.06, 0.02, 1.0);
+}
@@ -0,0 +1,17 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+in vec4 Color;
+
+uniform sampler2D overlayImage;
+
+void main() {
+	// plain colour quads carry negative texture coordinates
+	vec4 texColor = (TexCoord.x < 0.0) ? vec4(1.0) : texture(overlayImage, TexCoord);
+	texColor *= Color;
+	if (texColor.a < 0.1) {
+		discard;
+	}
+	FragColor = texColor;
+}
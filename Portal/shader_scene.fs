@@ -0,0 +1,49 @@
+#version 330 core
+// permutations, defined by the Shader building the program:
+// TEXTURE_ARRAY	samples texture_array at the layer of the vertex, otherwise texture_diffuse
+// PORTAL_VIEW		composites the offscreen portal view where the texture is opaque
+// ALPHA_MIN, ALPHA_MAX	discard the fragments with an alpha below or above them
+out vec4 FragColor;
+
+in vec2 TexCoords;
+#ifdef TEXTURE_ARRAY
+flat in float TexLayer;
+
+uniform sampler2DArray texture_array;
+#else
+uniform sampler2D texture_diffuse;
+#endif
+
+#ifdef PORTAL_VIEW
+uniform bool useView;
+uniform sampler2D texture_view;
+uniform vec4 viewRect;
+uniform vec2 viewScale;
+uniform vec2 screenSize;
+#endif
+
+void main() {
+#ifdef TEXTURE_ARRAY
+	vec4 texColor = texture(texture_array, vec3(TexCoords, TexLayer));
+#else
+	vec4 texColor = texture(texture_diffuse, TexCoords);
+#endif
+#ifdef PORTAL_VIEW
+	if (useView && texColor.a >= 1.0) {
+		vec2 ndc = gl_FragCoord.xy / screenSize * 2.0 - 1.0;
+		FragColor = texture(texture_view, (ndc - viewRect.xy) / (viewRect.zw - viewRect.xy) * viewScale);
+		return;
+	}
+#endif
+#ifdef ALPHA_MIN
+	if (texColor.a < ALPHA_MIN) {
+		discard;
+	}
+#endif
+#ifdef ALPHA_MAX
+	if (texColor.a > ALPHA_MAX) {
+		discard;
+	}
+#endif
+	FragColor = texColor;
+}
@@ -0,0 +1,48 @@
+#version 330 core
+// permutations, defined by the Shader building the program:
+// TEXTURE_ARRAY	the map, every vertex carries the layer of its texture
+// CLIP_PLANE		clips against clipPlane, for views through a portal
+// INSTANCED		transforms by the matrix of the instance, for the props of InstancedModels, otherwise the
+//					positions are world space
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+#ifdef TEXTURE_ARRAY
+layout (location = 5) in float aTexLayer;
+#endif
+#ifdef INSTANCED
+layout (location = 6) in mat4 aInstance;
+#endif
+
+out vec3 Normal;
+out vec2 TexCoords;
+#ifdef TEXTURE_ARRAY
+flat out float TexLayer;
+#endif
+
+uniform mat4 view;
+uniform mat4 projection;
+#ifdef CLIP_PLANE
+uniform vec4 clipPlane;
+#endif
+
+void main() {
+	TexCoords = aTexCoords;
+#ifdef TEXTURE_ARRAY
+	TexLayer = aTexLayer;
+#endif
+
+#if defined(INSTANCED)
+	vec4 worldPos = aInstance * vec4(aPos, 1.0);
+	// props are only moved, turned and scaled uniformly, which leaves the directions of the normals alone
+	Normal = mat3(aInstance) * aNormal;
+#else
+	vec4 worldPos = vec4(aPos, 1.0);
+	Normal = aNormal;
+#endif
+
+#ifdef CLIP_PLANE
+	gl_ClipDistance[0] = dot(worldPos, clipPlane);
+#endif
+	gl_Position = projection * view * worldPos;
+}